@@ -0,0 +1,159 @@
+/* tracedump.c
+ *
+ * This program reads a binary system call trace, as written by
+ * "nachos -st <file>", and summarizes it: for every process, how many
+ * times it made each system call, and the mean, minimum and maximum
+ * latency in simulated ticks, with a latency histogram.
+ *
+ * Usage: tracedump [-v] <trace file>
+ *	-v also prints every call, in the order they finished
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#define MAIN
+#include "copyright.h"
+#undef MAIN
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../userprog/tracefmt.h"
+
+#define MaxPids		64	/* MAX_PROCESSES in the kernel */
+#define NumBuckets	16	/* NumLatencyBuckets in the kernel */
+
+typedef struct {
+    int calls;
+    double totalTicks;
+    int minTicks;
+    int maxTicks;
+    int histogram[NumBuckets];
+} CallSummary;
+
+static CallSummary summary[MaxPids + 1][NumSyscallTypes];	/* last row: kernel */
+static const char *names[NumSyscallTypes] = SyscallNames;
+
+static int
+Bucket(int ticks)
+{
+    int bucket = 0;
+
+    while (ticks > 0 && bucket < NumBuckets - 1) {
+	ticks >>= 1;
+	bucket++;
+    }
+    return bucket;
+}
+
+static const char *
+Name(int type)
+{
+    static char unknown[16];
+
+    if (type >= 0 && type < NumSyscallTypes && names[type] != NULL)
+	return names[type];
+    sprintf(unknown, "SC_%d", type);
+    return unknown;
+}
+
+static void
+Account(TraceRecord *r)
+{
+    int row = (r->pid >= 0 && r->pid < MaxPids) ? r->pid : MaxPids;
+    int ticks = r->endTick - r->startTick;
+    CallSummary *s;
+
+    if (r->type < 0 || r->type >= NumSyscallTypes)
+	return;
+    s = &summary[row][r->type];
+    if (s->calls == 0 || ticks < s->minTicks)
+	s->minTicks = ticks;
+    if (ticks > s->maxTicks)
+	s->maxTicks = ticks;
+    s->calls++;
+    s->totalTicks += ticks;
+    s->histogram[Bucket(ticks)]++;
+}
+
+static void
+PrintSummary()
+{
+    int row, type, bucket;
+
+    for (row = 0; row <= MaxPids; row++) {
+	int any = 0;
+
+	for (type = 0; type < NumSyscallTypes; type++)
+	    any += summary[row][type].calls;
+	if (any == 0)
+	    continue;
+
+	if (row == MaxPids)
+	    printf("kernel threads:\n");
+	else
+	    printf("process %d:\n", row);
+	printf("  %-10s %8s %10s %8s %8s   latency histogram\n",
+	       "call", "count", "avg", "min", "max");
+	for (type = 0; type < NumSyscallTypes; type++) {
+	    CallSummary *s = &summary[row][type];
+
+	    if (s->calls == 0)
+		continue;
+	    printf("  %-10s %8d %10.1f %8d %8d  ", Name(type), s->calls,
+		   s->totalTicks / s->calls, s->minTicks, s->maxTicks);
+	    for (bucket = 0; bucket < NumBuckets; bucket++)
+		if (s->histogram[bucket] != 0) {
+		    if (bucket == NumBuckets - 1)
+			printf(" >=%d:%d", 1 << (bucket - 1), s->histogram[bucket]);
+		    else
+			printf(" <%d:%d", 1 << bucket, s->histogram[bucket]);
+		}
+	    printf("\n");
+	}
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    FILE *in;
+    TraceHeader header;
+    TraceRecord r;
+    int verbose = 0, numRecords = 0;
+
+    if (argc > 1 && !strcmp(argv[1], "-v")) {
+	verbose = 1;
+	argc--, argv++;
+    }
+    if (argc != 2) {
+	fprintf(stderr, "Usage: tracedump [-v] <trace file>\n");
+	exit(1);
+    }
+    if ((in = fopen(argv[1], "rb")) == NULL) {
+	perror(argv[1]);
+	exit(1);
+    }
+    if (fread(&header, sizeof(header), 1, in) != 1
+	    || header.magic != TraceMagic || header.version != TraceVersion) {
+	fprintf(stderr, "%s: not a Nachos system call trace\n", argv[1]);
+	exit(1);
+    }
+
+    while (fread(&r, sizeof(r), 1, in) == 1) {
+	if (verbose)
+	    printf("%10d %10d [%d] %s(%d, %d, %d, %d) = %d\n",
+		   r.startTick, r.endTick, r.pid, Name(r.type),
+		   r.args[0], r.args[1], r.args[2], r.args[3], r.result);
+	Account(&r);
+	numRecords++;
+    }
+    fclose(in);
+
+    printf("%d system calls\n", numRecords);
+    PrintSummary();
+    return 0;
+}
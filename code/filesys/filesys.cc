@@ -53,12 +53,6 @@
 #include "system.h"
 #include <string.h>
 
-// Sectors containing the file headers for the bitmap of free sectors,
-// and the directory of files.  These file headers are placed in well-known
-// sectors, so that they can be located on boot-up.
-#define FreeMapSector 0
-#define DirectorySector 1
-
 // Initial file sizes for the bitmap and directory; until the file system
 // supports extensible files, the directory size sets the maximum number
 // of files that can be loaded onto the disk.
@@ -354,7 +348,8 @@ bool FileSystem::Create(char *name, int initialSize, OpenFile *dFile = NULL, Bit
 //	  Find the location of the file's header, using the directory
 //	  Bring the header into memory
 //
-//	"name" -- the text name of the file to be opened
+//	"name" -- the text name of the file to be opened, or "" for the
+//	root directory
 //----------------------------------------------------------------------
 
 OpenFile *
@@ -366,7 +361,10 @@ FileSystem::Open(char *name)
 
     DEBUG('f', "Opening file %s\n", name);
     directory->FetchFrom(directoryFile);
-    sector = directory->Find(name);
+    if (*name == '\0')
+        sector = DirectorySector;
+    else
+        sector = directory->Find(name);
     if (sector >= 0)
         openFile = new OpenFile(sector); // name was found in directory
     delete directory;
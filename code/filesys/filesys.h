@@ -41,6 +41,12 @@
 
 #define NumDirEntries 10
 
+// Sectors containing the file headers for the bitmap of free sectors,
+// and the directory of files.  These file headers are placed in well-known
+// sectors, so that they can be located on boot-up.
+#define FreeMapSector 0
+#define DirectorySector 1
+
 #ifdef FILESYS_STUB // Temporarily implement file system calls as
 // calls to UNIX, until the real file system
 // implementation is available
@@ -88,7 +94,8 @@ class FileSystem
 	bool Create(char *name, int initialSize, OpenFile *dFile = NULL, BitMap *freeMap = NULL, int depth = 0);
 	// Create a file (UNIX creat)
 
-	OpenFile *Open(char *name); // Open a file (UNIX open)
+	OpenFile *Open(char *name); // Open a file (UNIX open);
+								// "" opens the root directory
 
 	bool Remove(char *name, OpenFile *dFile = NULL); // Delete a file (UNIX unlink)
 
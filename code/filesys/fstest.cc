@@ -7,6 +7,7 @@
 //	   Perftest -- a stress test for the Nachos file system
 //		read and write a really large file in tiny chunks
 //		(won't work on baseline system!)
+//	   ReadTest -- several threads read one open file at once
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -20,6 +21,8 @@
 #include "thread.h"
 #include "disk.h"
 #include "stats.h"
+#include "directory.h"
+#include "synchdisk.h"
 
 #define TransferSize 10 // make it small, just to be difficult
 
@@ -251,31 +254,138 @@ void PerformanceTest()
     }
 }
 
-static OpenFile *ppipe;
+static OpenFile *pipeIn, *pipeOut;	// read and write ends
 
 void
 PipeRead(int dummy)
 {
-    char *buffer = new char[ContentSize + 1];
-    ppipe->Read(buffer, ContentSize);
-    buffer[ContentSize] = '\0';
+    char *buffer = new char[FileSize + 1];
+    int total = 0, numBytes;
+
+    while ((numBytes = pipeIn->Read(buffer + total, FileSize - total)) > 0)
+        total += numBytes;		// until end of file
+    buffer[total] = '\0';
     printf("Thread %d \"%s\" read:\n", currentThread->getTid(), currentThread->getName());
     printf("%s\n", buffer);
+    delete pipeIn;
+    delete[] buffer;
 }
 
 void
 PipeWrite(int dummy)
 {
-    ppipe->Write(Contents, ContentSize);
+    pipeOut->Write(Contents, ContentSize);
+    pipeOut->Write(Contents2, ContentSize);
+    pipeOut->Write(Contents3, ContentSize);
     printf("Thread %d \"%s\" write:\n", currentThread->getTid(), currentThread->getName());
+    delete pipeOut;			// the reader sees end of file
 }
 
+//----------------------------------------------------------------------
+// PipeTest
+// 	A writer puts three strings through a pipe and closes its end; the
+//	reader reads until end of file, and should print them in order.
+//----------------------------------------------------------------------
+
 void PipeTest()
 {
-    ppipe = new OpenFile(-1);
+    Pipe *pipe = new Pipe;
+    pipeIn = new OpenFile(pipe, FALSE);
+    pipeOut = new OpenFile(pipe, TRUE);
     Thread *tr = new Thread("reader");
     Thread *tw = new Thread("writer");
     tr->Fork(PipeRead, (void*)1);
     tw->Fork(PipeWrite, (void*)2);
-    
+}
+
+//----------------------------------------------------------------------
+// ReadTest
+// 	Several threads ReadAt the same open file at once, each starting
+//	at a different sector, and check what they read.  Since reads
+//	only share the header's lock, one reader's disk wait lets the
+//	others in: the lock should see them overlap, and nothing should
+//	be written to the disk until the file is closed.
+//----------------------------------------------------------------------
+
+#define ReadFileName "ReadFile"
+#define ReadFileSize (4 * SectorSize)
+#define NumReaders 3
+
+static OpenFile *readFile;		// shared by all the readers
+static Semaphore *readsDone;		// V'ed by each reader when it is done
+
+static char
+ReadPattern(int position)
+{
+    return 'a' + position % 26;
+}
+
+static void
+ConcurrentRead(int which)
+{
+    char buffer[SectorSize];
+    int bad = 0;
+
+    for (int i = 0; i < ReadFileSize / SectorSize; i++)
+    {
+        int position = ((which + i) % (ReadFileSize / SectorSize)) * SectorSize;
+        int numBytes = readFile->ReadAt(buffer, SectorSize, position);
+
+        for (int j = 0; j < SectorSize; j++)
+            if (j >= numBytes || buffer[j] != ReadPattern(position + j))
+                bad++;
+    }
+    printf("Thread %d \"%s\" read %d bytes, %d wrong\n", currentThread->getTid(),
+           currentThread->getName(), ReadFileSize, bad);
+    readsDone->V();
+}
+
+void ReadTest()
+{
+    char buffer[ReadFileSize];
+    int i, sector, writes;
+
+    printf("Starting concurrent read test:\n");
+    if (!fileSystem->Create(ReadFileName, 0))
+    {
+        printf("Read test: can't create %s\n", ReadFileName);
+        return;
+    }
+    readFile = fileSystem->Open(ReadFileName);
+    for (i = 0; i < ReadFileSize; i++)
+        buffer[i] = ReadPattern(i);
+    if (readFile->WriteAt(buffer, ReadFileSize, 0) < ReadFileSize)
+    {
+        printf("Read test: unable to write %s\n", ReadFileName);
+        delete readFile;
+        fileSystem->Remove(ReadFileName);
+        return;
+    }
+
+    OpenFile *dirFile = new OpenFile(DirectorySector);
+    Directory *directory = new Directory(NumDirEntries);
+    directory->FetchFrom(dirFile);
+    sector = directory->Find(ReadFileName);
+    delete directory;
+    delete dirFile;
+
+    readsDone = new Semaphore("reads done", 0);
+    writes = stats->numDiskWrites;
+    for (i = 0; i < NumReaders; i++)
+    {
+        Thread *t = new Thread("reader");
+        t->Fork(ConcurrentRead, (void *)i);
+    }
+    for (i = 0; i < NumReaders; i++)
+        readsDone->P();
+
+    synchDisk->rwlock[sector].Print();
+    printf("Readers %s, %d disk writes while reading\n",
+           (synchDisk->rwlock[sector].peakReaders > 1) ? "overlapped"
+                                                      : "did not overlap",
+           stats->numDiskWrites - writes);
+    delete readsDone;
+    delete readFile;
+    if (!fileSystem->Remove(ReadFileName))
+        printf("Read test: unable to remove %s\n", ReadFileName);
 }
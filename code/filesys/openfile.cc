@@ -13,6 +13,7 @@
 
 #include "copyright.h"
 #include "filehdr.h"
+#include "filesys.h"
 #include "openfile.h"
 #include "system.h"
 
@@ -31,26 +32,75 @@
 
 OpenFile::OpenFile(int sector)
 {
-    usePipe = (sector == -1);
-    if (!usePipe)
-    {
-        hdr = new FileHeader;
-        hdr->FetchFrom(sector);
-        seekPosition = 0;
-        hdrSector = sector;
-        synchDisk->numVisitor[sector]++;
-    }
+    usePipe = FALSE;
+    pipe = NULL;
+    hdr = new FileHeader;
+    hdr->FetchFrom(sector);
+    seekPosition = 0;
+    hdrSector = sector;
+    used = FALSE;
+    synchDisk->numVisitor[sector]++;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::OpenFile
+// 	Open one end of a pipe: the write end if "writing", otherwise the
+//	read end.  A pipe end has no header and no position; Tell always
+//	returns 0.
+//----------------------------------------------------------------------
+
+OpenFile::OpenFile(Pipe *p, bool writing)
+{
+    usePipe = TRUE;
+    pipe = p;
+    pipeWriter = writing;
+    hdr = NULL;
+    seekPosition = 0;
+    hdrSector = -1;
+    used = FALSE;
+    pipe->OpenEnd(writing);
+}
+
+//----------------------------------------------------------------------
+// OpenFile::Dup
+// 	Return a new open file for the same end of the same pipe, as a
+//	child process gets when it inherits the descriptor.
+//----------------------------------------------------------------------
+
+OpenFile *
+OpenFile::Dup()
+{
+    ASSERT(usePipe);
+    return new OpenFile(pipe, pipeWriter);
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
 // 	Close a Nachos file, de-allocating any in-memory data structures.
+//	Closing the last end of a pipe deletes the pipe.
+//
+//	If the file has been read since its header was last written back,
+//	record the used time now.  The header is fetched afresh first, so
+//	that changes made through other open files are not overwritten.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
-    if (!usePipe)
+    if (usePipe)
+    {
+        if (pipe->CloseEnd(pipeWriter))
+            delete pipe;
+    }
+    else
     {
+        if (used)
+        {
+            synchDisk->rwlock[hdrSector].WriteLock();
+            hdr->FetchFrom(hdrSector);
+            hdr->SetUsedTime();
+            hdr->WriteBack(hdrSector);
+            synchDisk->rwlock[hdrSector].WriteUnlock();
+        }
         synchDisk->numVisitor[hdrSector]--;
         if (synchDisk->numVisitor[hdrSector] == 0)
             synchDisk->secCond[hdrSector]->Signal(synchDisk->secLock[hdrSector]);
@@ -87,10 +137,7 @@ void OpenFile::Seek(int position)
 int OpenFile::Read(char *into, int numBytes)
 {
     if (usePipe)
-    {
-        ReadPipe(into, numBytes);
-        return numBytes;
-    }
+        return pipeWriter ? -1 : pipe->Read(into, numBytes);
     else
     {
         int result = ReadAt(into, numBytes, seekPosition);
@@ -102,10 +149,7 @@ int OpenFile::Read(char *into, int numBytes)
 int OpenFile::Write(char *into, int numBytes)
 {
     if (usePipe)
-    {
-        WritePipe(into, numBytes);
-        return numBytes;
-    }
+        return pipeWriter ? pipe->Write(into, numBytes) : -1;
     else
     {
         int result = WriteAt(into, numBytes, seekPosition);
@@ -126,7 +170,9 @@ int OpenFile::Write(char *into, int numBytes)
 //
 //	For ReadAt:
 //	   We read in all of the full or partial sectors that are part of the
-//	   request, but we only copy the part we are interested in.
+//	   request, but we only copy the part we are interested in.  Nothing
+//	   is written, so the header's lock is only held shared, and readers
+//	   of the file overlap; the used time waits for close.
 //	For WriteAt:
 //	   We must first read in any sectors that will be partially written,
 //	   so that we don't overwrite the unmodified portion.  We then copy
@@ -170,11 +216,8 @@ int OpenFile::ReadAt(char *into, int numBytes, int position)
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
     delete[] buf;
+    used = TRUE; // the used time is written back on close
     synchDisk->rwlock[hdrSector].ReadUnlock();
-    synchDisk->rwlock[hdrSector].WriteLock();
-    hdr->SetUsedTime();
-    hdr->WriteBack(hdrSector);
-    synchDisk->rwlock[hdrSector].WriteUnlock();
     return numBytes;
 }
 
@@ -187,7 +230,10 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     char *buf;
 
     if (numBytes <= 0)
+    {
+        synchDisk->rwlock[hdrSector].WriteUnlock();
         return 0; // check request
+    }
     if (position + numBytes > fileLength)
     {
         OpenFile *freeMapFile = new OpenFile(0);
@@ -239,6 +285,7 @@ int OpenFile::WriteAt(char *from, int numBytes, int position)
     hdr->SetModTime();
     hdr->SetUsedTime();
     hdr->WriteBack(hdrSector);
+    used = FALSE;
     synchDisk->rwlock[hdrSector].WriteUnlock();
     return numBytes;
 }
@@ -256,4 +303,15 @@ int OpenFile::Length()
 void OpenFile::Print()
 {
     hdr->Print();
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------
+// OpenFile::IsDirectory
+// 	Return TRUE if this file holds a directory.  The root directory
+//	is recognized by its well-known header sector.
+//----------------------------------------------------------------------
+
+bool OpenFile::IsDirectory()
+{
+    return !usePipe && (hdrSector == DirectorySector || hdr->GetIfDir());
+}
@@ -63,8 +63,10 @@ class OpenFile
 	int Length()
 	{
 		Lseek(file, 0, 2);
-		return Tell(file);
+		return ::Tell(file);
 	}
+	void Seek(int position) { currentOffset = position; }
+	int Tell() { return currentOffset; }
 
   private:
 	int file;
@@ -73,16 +75,22 @@ class OpenFile
 
 #else // FILESYS
 class FileHeader;
+class Pipe;
 
 class OpenFile
 {
   public:
 	OpenFile(int sector); // Open a file whose header is located
 						  // at "sector" on the disk
+	OpenFile(Pipe *p, bool writing); // Open the write end of "p" (if
+									 // "writing") or its read end
+	OpenFile *Dup();				 // Another open file for the same
+									 // pipe end (pipes only)
 	~OpenFile();		  // Close the file
 
 	void Seek(int position); // Set the position from which to
 							 // start reading/writing -- UNIX lseek
+	int Tell() { return seekPosition; } // Return that position
 
 	int Read(char *into, int numBytes); // Read/write bytes from the file,
 										// starting at the implicit position.
@@ -100,13 +108,18 @@ class OpenFile
 				  // than the UNIX idiom -- lseek to
 				  // end of file, tell, lseek back
 	void Print();
+	bool IsDirectory(); // Is this file a directory?
 	bool usePipe;
 
   private:
+	Pipe *pipe;		 // if usePipe, the pipe we are an end of
+	bool pipeWriter; // if usePipe, TRUE for the write end
 	FileHeader *hdr; // Header for this file
 	bool is_directory;
 	int hdrSector;
 	int seekPosition; // Current position within the file
+	bool used;		  // Read since the header was last written
+					  // back; its used time is stamped on close
 };
 
 #endif // FILESYS
@@ -16,6 +16,7 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "system.h"
 #include <string.h>
 
 //----------------------------------------------------------------------
@@ -84,6 +85,10 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
+#ifdef USER_PROGRAM
+    if (currentThread->process != NULL)
+	currentThread->process->usage.diskReads++;
+#endif
     lock->Acquire();			// only one disk I/O at a time
     disk->ReadRequest(sectorNumber, data);
     semaphore->P();			// wait for interrupt
@@ -102,6 +107,10 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
+#ifdef USER_PROGRAM
+    if (currentThread->process != NULL)
+	currentThread->process->usage.diskWrites++;
+#endif
     lock->Acquire();			// only one disk I/O at a time
     disk->WriteRequest(sectorNumber, data);
     semaphore->P();			// wait for interrupt
@@ -53,9 +53,27 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     readHandler = readAvail;
     handlerArg = callArg;
     putBusy = FALSE;
+    putCount = 0;
     incoming = EOF;
+    inputEnded = FALSE;
 
     // start polling for incoming packets
+    if (readHandler != NULL)
+	interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime,
+			    ConsoleReadInt);
+}
+
+//----------------------------------------------------------------------
+// Console::StartInput
+// 	Start polling the simulated keyboard of a console created with
+//	no read handler, and call "readAvail" when a character arrives.
+//----------------------------------------------------------------------
+
+void
+Console::StartInput(VoidFunctionPtr readAvail)
+{
+    ASSERT(readHandler == NULL);
+    readHandler = readAvail;
     interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, ConsoleReadInt);
 }
 
@@ -81,6 +99,9 @@ Console::~Console()
 //	character has been grabbed out of the buffer by the Nachos kernel).
 //	Invoke the "read" interrupt handler, once the character has been 
 //	put into the buffer. 
+//
+//	At the end of the file, invoke the handler once more, with no
+//	character, and stop polling.
 //----------------------------------------------------------------------
 
 void
@@ -88,6 +109,9 @@ Console::CheckCharAvail()
 {
     char c;
 
+    if (inputEnded)			// nothing more will ever arrive
+	return;
+
     // schedule the next time to poll for a packet
     interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
 			ConsoleReadInt);
@@ -97,7 +121,11 @@ Console::CheckCharAvail()
 	return;	  
 
     // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    if (ReadPartial(readFileNo, &c, sizeof(char)) != sizeof(char)) {
+	inputEnded = TRUE;		// end of file
+	(*readHandler)(handlerArg);
+	return;
+    }
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
@@ -114,7 +142,7 @@ void
 Console::WriteDone()
 {
     putBusy = FALSE;
-    stats->numConsoleCharsWritten++;
+    stats->numConsoleCharsWritten += putCount;
     (*writeHandler)(handlerArg);
 }
 
@@ -142,9 +170,41 @@ Console::GetChar()
 void
 Console::PutChar(char ch)
 {
-    ASSERT(putBusy == FALSE);
-    WriteFile(writeFileNo, &ch, sizeof(char));
+    PutChars(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// Console::PutChars()
+// 	Write "count" characters to the simulated display in one host
+//	write, and schedule a single interrupt for the lot, as a DMA
+//	device would.
+//----------------------------------------------------------------------
+
+void
+Console::PutChars(char *data, int count)
+{
+    ASSERT(putBusy == FALSE && count > 0);
+    if (writeFileNo == 1)
+	fflush(stdout);		// keep the kernel's printf's in order
+    WriteFile(writeFileNo, data, count);
     putBusy = TRUE;
+    putCount = count;
     interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
 					ConsoleWriteInt);
 }
+
+//----------------------------------------------------------------------
+// Console::WriteNow()
+// 	Write "count" characters to the simulated display, without
+//	simulating the device.  Used to flush buffered output when
+//	Nachos is shutting down, and there will be no more interrupts.
+//----------------------------------------------------------------------
+
+void
+Console::WriteNow(char *data, int count)
+{
+    if (writeFileNo == 1)
+	fflush(stdout);
+    WriteFile(writeFileNo, data, count);
+    stats->numConsoleCharsWritten += count;
+}
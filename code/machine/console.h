@@ -14,6 +14,13 @@
 //	for read and write, and the device is "duplex" -- a character
 //	can be outgoing and incoming at the same time.
 //
+//	Output can also be done in bursts, like a DMA transfer: PutChars
+//	hands the device a whole buffer, which costs one interrupt rather
+//	than one per character.  The keyboard is only polled once there is
+//	a read handler, since the polling keeps interrupts pending forever.
+//	At the end of the input file, the read handler is called one last
+//	time with no character, InputEnded turns TRUE, and polling stops.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -39,18 +46,31 @@ class Console {
   public:
     Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail, 
 	VoidFunctionPtr writeDone, int callArg);
-				// initialize the hardware console device
+				// initialize the hardware console device;
+				// "readAvail" may be NULL, for output only
     ~Console();			// clean up console emulation
 
 // external interface -- Nachos kernel code can call these
     void PutChar(char ch);	// Write "ch" to the console display, 
 				// and return immediately.  "writeHandler" 
 				// is called when the I/O completes. 
+    void PutChars(char *data, int count);
+				// Write "count" characters at once;
+				// "writeHandler" is called once, when
+				// they are all out
+    void WriteNow(char *data, int count);
+				// Write straight to the display, with no
+				// interrupt -- for flushing at shutdown
+    void StartInput(VoidFunctionPtr readAvail);
+				// Start polling the keyboard, calling
+				// "readAvail" as characters arrive
 
     char GetChar();	   	// Poll the console input.  If a char is 
 				// available, return it.  Otherwise, return EOF.
     				// "readHandler" is called whenever there is 
 				// a char to be gotten
+    bool InputEnded() { return inputEnded; }
+				// Has the keyboard file run out?
 
 // internal emulation routines -- DO NOT call these. 
     void WriteDone();	 	// internal routines to signal I/O completion
@@ -67,9 +87,11 @@ class Console {
 					// interrupt handlers
     bool putBusy;    			// Is a PutChar operation in progress?
 					// If so, you can't do another one!
+    int putCount;			// characters in the operation
     char incoming;    			// Contains the character to be read,
 					// if there is one available. 
 					// Otherwise contains EOF.
+    bool inputEnded;			// end of the keyboard file reached
 };
 
 #endif // CONSOLE_H
@@ -28,27 +28,10 @@
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "elevator", "network send",
+			"network recv", "alarm"};
 
-//----------------------------------------------------------------------
-// PendingInterrupt::PendingInterrupt
-// 	Initialize a hardware device interrupt that is to be scheduled 
-//	to occur in the near future.
-//
-//	"func" is the procedure to call when the interrupt occurs
-//	"param" is the argument to pass to the procedure
-//	"time" is when (in simulated time) the interrupt is to occur
-//	"kind" is the hardware device that generated the interrupt
-//----------------------------------------------------------------------
-
-PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time, 
-				IntType kind)
-{
-    handler = func;
-    arg = param;
-    when = time;
-    type = kind;
-}
+#define InitialPoolSize	16	// room for every device, to begin with
 
 //----------------------------------------------------------------------
 // Interrupt::Interrupt
@@ -60,7 +43,12 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    events = NULL;
+    pending = NULL;
+    poolSize = numPending = 0;
+    freeEvents = -1;
+    nextOrder = 0;
+    GrowPool();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -73,9 +61,8 @@ Interrupt::Interrupt()
 
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty())
-	delete (PendingInterrupt *)pending->Remove();
-    delete pending;
+    delete [] events;
+    delete [] pending;
 }
 
 //----------------------------------------------------------------------
@@ -160,6 +147,16 @@ Interrupt::OneTick()
 	stats->totalTicks += UserTick;
 	stats->userTicks += UserTick;
     }
+#ifdef USER_PROGRAM
+    if (currentThread->process != NULL) {	// charge the running process
+	if (status == SystemMode)
+	    currentThread->process->usage.systemTicks += SystemTick;
+	else
+	    currentThread->process->usage.userTicks += UserTick;
+    }
+    if (machine != NULL)			// not yet, while booting
+	machine->WriteInfo(InfoTicks, stats->totalTicks);
+#endif
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
 // check any pending interrupts are now ready to fire
@@ -242,6 +239,10 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    scheduler->PrintStats();
+#ifdef USER_PROGRAM
+    PrintProcessStates();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -250,28 +251,75 @@ Interrupt::Halt()
 // 	Arrange for the CPU to be interrupted when simulated time
 //	reaches "now + when".
 //
-//	Implementation: just put it on a sorted list.
+//	Implementation: take an event from the free pool, and push it on
+//	a heap ordered by firing time, in O(log n) and without allocating
+//	anything (unless the pool has to grow).
 //
 //	NOTE: the Nachos kernel should not call this routine directly.
 //	Instead, it is only called by the hardware device simulators.
 //
+//	Returns a handle that can be passed to Cancel.  Handles are
+//	never 0, so 0 can stand for "nothing scheduled".
+//
 //	"handler" is the procedure to call when the interrupt occurs
 //	"arg" is the argument to pass to the procedure
 //	"fromNow" is how far in the future (in simulated time) the 
 //		 interrupt is to occur
 //	"type" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
-void
+int
 Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
+    int event;
+    PendingInterrupt *toOccur;
 
     DEBUG('i', "Scheduling interrupt handler the %s at time = %d\n", 
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    if (freeEvents == -1)
+	GrowPool();
+    event = freeEvents;
+    toOccur = &events[event];
+    freeEvents = toOccur->nextFree;
+    toOccur->handler = handler;
+    toOccur->arg = arg;
+    toOccur->when = when;
+    toOccur->type = type;
+    toOccur->order = nextOrder++;
+
+    Place(numPending++, event);
+    SiftUp(numPending - 1);
+    return (toOccur->generation << PendingIndexBits) | event;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Cancel
+// 	Unschedule an interrupt, so that its handler is never called.
+//
+// Returns:
+//	TRUE, if it was still pending; FALSE if it has already fired,
+//	or been cancelled.
+// Params:
+//	"handle" -- what Schedule returned
+//----------------------------------------------------------------------
+bool
+Interrupt::Cancel(int handle)
+{
+    int event = handle & ((1 << PendingIndexBits) - 1);
+    PendingInterrupt *toCancel;
+
+    if (handle <= 0 || event >= poolSize)
+	return FALSE;
+    toCancel = &events[event];
+    if (toCancel->heapPos == -1 ||
+		toCancel->generation != (handle >> PendingIndexBits))
+	return FALSE;
+    DEBUG('i', "Cancelling interrupt handler the %s at time = %d\n",
+		intTypeNames[toCancel->type], toCancel->when);
+    RemovePending(toCancel->heapPos);
+    return TRUE;
 }
 
 //----------------------------------------------------------------------
@@ -291,35 +339,35 @@ bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
-    int when;
 
     ASSERT(level == IntOff);		// interrupts need to be disabled,
 					// to invoke an interrupt handler
     if (DebugIsEnabled('i'))
 	DumpState();
-    PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
 
-    if (toOccur == NULL)		// no pending interrupts
+    if (numPending == 0)		// no pending interrupts
 	return FALSE;			
+    PendingInterrupt *toOccur = &events[pending[0]];
+    int when = toOccur->when;
 
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks)	// not time yet
 	return FALSE;
-    }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& numPending == 1)
 	 return FALSE;
-    }
+
+    VoidFunctionPtr handler = toOccur->handler;
+    int arg = toOccur->arg;
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
-			intTypeNames[toOccur->type], toOccur->when);
+			intTypeNames[toOccur->type], when);
+    RemovePending(0);			// free it first, so that a handler
+					// rescheduling itself can reuse it
 #ifdef USER_PROGRAM
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
@@ -328,13 +376,130 @@ Interrupt::CheckIfDue(bool advanceClock)
     status = SystemMode;			// whatever we were doing,
 						// we are now going to be
 						// running in the kernel
-    (*(toOccur->handler))(toOccur->arg);	// call the interrupt handler
+    (*handler)(arg);				// call the interrupt handler
     status = old;				// restore the machine status
     inHandler = FALSE;
-    delete toOccur;
     return TRUE;
 }
 
+//----------------------------------------------------------------------
+// Interrupt::GrowPool
+// 	Double the number of PendingInterrupts we can have scheduled at
+//	once, and put the new ones on the free list.  Handles stay valid,
+//	since they are indices into the pool.
+//----------------------------------------------------------------------
+void
+Interrupt::GrowPool()
+{
+    int newSize = (poolSize == 0) ? InitialPoolSize : 2 * poolSize;
+    PendingInterrupt *newEvents = new PendingInterrupt[newSize];
+    int *newPending = new int[newSize];
+    int i;
+
+    ASSERT(newSize <= (1 << PendingIndexBits));
+    for (i = 0; i < poolSize; i++)
+	newEvents[i] = events[i];
+    for (i = 0; i < numPending; i++)
+	newPending[i] = pending[i];
+    for (i = newSize - 1; i >= poolSize; i--) {
+	newEvents[i].heapPos = -1;
+	newEvents[i].generation = 1;
+	newEvents[i].nextFree = freeEvents;
+	freeEvents = i;
+    }
+    delete [] events;
+    delete [] pending;
+    events = newEvents;
+    pending = newPending;
+    poolSize = newSize;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Earlier
+// 	Return TRUE if event "a" is to fire before event "b": it is due
+//	sooner, or it is due at the same time and was scheduled first.
+//----------------------------------------------------------------------
+bool
+Interrupt::Earlier(int a, int b)
+{
+    if (events[a].when != events[b].when)
+	return events[a].when < events[b].when;
+    return events[a].order < events[b].order;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::Place
+// 	Put "event" in slot "pos" of the heap, and remember where it is.
+//----------------------------------------------------------------------
+void
+Interrupt::Place(int pos, int event)
+{
+    pending[pos] = event;
+    events[event].heapPos = pos;
+}
+
+//----------------------------------------------------------------------
+// Interrupt::SiftUp, Interrupt::SiftDown
+// 	Move the heap entry at "pos" up towards the top while it is
+//	earlier than its parent, or down while one of its children is
+//	earlier than it.
+//----------------------------------------------------------------------
+void
+Interrupt::SiftUp(int pos)
+{
+    int event = pending[pos];
+
+    while (pos > 0 && Earlier(event, pending[(pos - 1) / 2])) {
+	Place(pos, pending[(pos - 1) / 2]);
+	pos = (pos - 1) / 2;
+    }
+    Place(pos, event);
+}
+
+void
+Interrupt::SiftDown(int pos)
+{
+    int event = pending[pos];
+    int child;
+
+    while ((child = 2 * pos + 1) < numPending) {
+	if (child + 1 < numPending && Earlier(pending[child + 1], pending[child]))
+	    child++;
+	if (!Earlier(pending[child], event))
+	    break;
+	Place(pos, pending[child]);
+	pos = child;
+    }
+    Place(pos, event);
+}
+
+//----------------------------------------------------------------------
+// Interrupt::RemovePending
+// 	Take the entry at heap slot "pos" off the heap, fill the hole
+//	with the last entry, and put the event back on the free list.
+//----------------------------------------------------------------------
+void
+Interrupt::RemovePending(int pos)
+{
+    int event = pending[pos];
+    PendingInterrupt *removed = &events[event];
+
+    numPending--;
+    if (pos < numPending) {
+	int last = pending[numPending];
+
+	Place(pos, last);
+	SiftDown(pos);
+	SiftUp(events[last].heapPos);
+    }
+    removed->heapPos = -1;
+    removed->generation = (removed->generation + 1) & 0x7fff;
+    if (removed->generation == 0)
+	removed->generation = 1;		// handles are never 0
+    removed->nextFree = freeEvents;
+    freeEvents = event;
+}
+
 //----------------------------------------------------------------------
 // PrintPending
 // 	Print information about an interrupt that is scheduled to occur.
@@ -342,10 +507,8 @@ Interrupt::CheckIfDue(bool advanceClock)
 //----------------------------------------------------------------------
 
 static void
-PrintPending(int arg)
+PrintPending(PendingInterrupt *pend)
 {
-    PendingInterrupt *pend = (PendingInterrupt *)arg;
-
     printf("Interrupt handler %s, scheduled at %d\n", 
 	intTypeNames[pend->type], pend->when);
 }
@@ -353,7 +516,8 @@ PrintPending(int arg)
 //----------------------------------------------------------------------
 // DumpState
 // 	Print the complete interrupt state - the status, and all interrupts
-//	that are scheduled to occur in the future.
+//	that are scheduled to occur in the future (in heap order, which
+//	is not quite the order they will fire in).
 //----------------------------------------------------------------------
 
 void
@@ -363,7 +527,8 @@ Interrupt::DumpState()
 					intLevelNames[level]);
     printf("Pending interrupts:\n");
     fflush(stdout);
-    pending->Mapcar(PrintPending);
+    for (int i = 0; i < numPending; i++)
+	PrintPending(&events[pending[i]]);
     printf("End of pending interrupts\n");
     fflush(stdout);
 }
@@ -36,7 +36,7 @@
 #define INTERRUPT_H
 
 #include "copyright.h"
-#include "list.h"
+#include "utility.h"
 
 // Interrupts can be disabled (IntOff) or enabled (IntOn)
 enum IntStatus { IntOff, IntOn };
@@ -48,27 +48,39 @@ enum MachineStatus {IdleMode, SystemMode, UserMode};
 
 // IntType records which hardware device generated an interrupt.
 // In Nachos, we support a hardware timer device, a disk, a console
-// display and keyboard, and a network.
+// display and keyboard, and a network.  AlarmInt wakes up a thread
+// that asked to sleep for a while (see Thread::SleepFor).
 enum IntType { TimerInt, DiskInt, ConsoleWriteInt, ConsoleReadInt, 
-				ElevatorInt, NetworkSendInt, NetworkRecvInt};
+				ElevatorInt, NetworkSendInt, NetworkRecvInt,
+				AlarmInt};
 
 // The following class defines an interrupt that is scheduled
 // to occur in the future.  The internal data structures are
 // left public to make it simpler to manipulate.
+//
+// PendingInterrupts are not allocated one by one: the Interrupt
+// object keeps a pool of them, and recycles each one as soon as it
+// fires or is cancelled.
 
 class PendingInterrupt {
   public:
-    PendingInterrupt(VoidFunctionPtr func, int param, int time, IntType kind);
-				// initialize an interrupt that will
-				// occur in the future
-
     VoidFunctionPtr handler;    // The function (in the hardware device
 				// emulator) to call when the interrupt occurs
     int arg;                    // The argument to the function.
     int when;			// When the interrupt is supposed to fire
     IntType type;		// for debugging
+
+    int order;			// when it was scheduled, so that interrupts
+				// due at the same time fire in that order
+    int heapPos;		// where it is in the heap; -1 if it is free
+    int generation;		// bumped each time it is recycled, so a
+				// stale handle cannot cancel its successor
+    int nextFree;		// next one in the free list
 };
 
+#define PendingIndexBits	16	// a handle is the pool index, with
+					// the generation above it
+
 // The following class defines the data structures for the simulation
 // of hardware interrupts.  We record whether interrupts are enabled
 // or disabled, and any hardware interrupts that are scheduled to occur
@@ -106,16 +118,24 @@ class Interrupt {
     // but they need to be public since they are called by the
     // hardware device simulators.
 
-    void Schedule(VoidFunctionPtr handler,// Schedule an interrupt to occur
+    int Schedule(VoidFunctionPtr handler,// Schedule an interrupt to occur
 	int arg, int when, IntType type);// at time ``when''.  This is called
     					// by the hardware device simulators.
+					// Returns a handle for Cancel, never 0
+    bool Cancel(int handle);		// Unschedule it, if it has not fired
     
     void OneTick();       		// Advance simulated time
 
   private:
     IntStatus level;		// are interrupts enabled or disabled?
-    List *pending;		// the list of interrupts scheduled
-				// to occur in the future
+    PendingInterrupt *events;	// the pool of interrupts, scheduled or free
+    int poolSize;		// entries in "events"
+    int freeEvents;		// head of the free list, -1 if none
+    int *pending;		// the interrupts scheduled to occur in the
+				// future, as a heap of "events" indices:
+				// the one to fire next is at the top
+    int numPending;		// entries in "pending"
+    int nextOrder;		// "order" for the next Schedule
     bool inHandler;		// TRUE if we are running an interrupt handler
     bool yieldOnReturn; 	// TRUE if we are to context switch
 				// on return from the interrupt handler
@@ -128,6 +148,14 @@ class Interrupt {
 
     void ChangeLevel(IntStatus old, 	// SetLevel, without advancing the
 	IntStatus now);  		// simulated time
+
+    void GrowPool();			// double the pool, when it runs out
+    bool Earlier(int a, int b);		// should event "a" fire before "b"?
+    void Place(int pos, int event);	// put "event" at heap slot "pos"
+    void SiftUp(int pos);		// restore the heap after an entry at
+    void SiftDown(int pos);		// "pos" moved earlier, or later
+    void RemovePending(int pos);	// take the entry at "pos" off the
+					// heap, and free its event
 };
 
 #endif // INTERRRUPT_H
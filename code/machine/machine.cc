@@ -58,8 +58,8 @@ Machine::Machine(bool debug)
 
     for (i = 0; i < NumTotalRegs; i++)
         registers[i] = 0;
-    mainMemory = new char[MemorySize];
-    for (i = 0; i < MemorySize; i++)
+    mainMemory = new char[MemorySize + PageSize];	// and the info page
+    for (i = 0; i < MemorySize + PageSize; i++)
       	mainMemory[i] = 0;
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLBSize];
@@ -213,3 +213,17 @@ void Machine::WriteRegister(int num, int value)
 	registers[num] = value;
     }
 
+
+//----------------------------------------------------------------------
+// Machine::WriteInfo
+//   	Store "value" as word "which" of the kernel info page, in the
+//	byte order of the simulated machine, where user programs will
+//	read it.
+//----------------------------------------------------------------------
+
+void Machine::WriteInfo(int which, int value)
+{
+    int *info = (int *)&mainMemory[KernelInfoFrame * PageSize];
+
+    info[which] = WordToMachine(value);
+}
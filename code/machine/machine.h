@@ -37,6 +37,21 @@
 #define MemorySize 	(NumPhysPages * PageSize)
 #define TLBSize		4		// if there is a TLB, make it small
 
+// The kernel info page: one page of physical memory, past the ones
+// user programs are given, that appears read-only at KernelInfoAddr in
+// every address space, whatever its page table or TLB says.  The kernel
+// keeps a few words there up to date, so that a user program can read
+// them with a plain load instead of a system call.  The layout is
+// KernelInfo, in syscall.h.
+
+#define KernelInfoAddr	0x7fff0000	// keep in step with syscall.h
+#define KernelInfoFrame	NumPhysPages	// physical page number
+
+#define InfoTicks	0		// stats->totalTicks
+#define InfoPid		1		// pid of the running process
+#define InfoTid		2		// tid of the running thread
+#define InfoCpu		3		// which CPU we are on (always 0)
+
 enum ExceptionType { NoException,           // Everything ok!
 		     SyscallException,      // A program executed a system call.
 		     PageFaultException,    // No valid translation found
@@ -119,6 +134,9 @@ class Machine {
     void WriteRegister(int num, int value);
 				// store a value into a CPU register
 
+    void WriteInfo(int which, int value);
+				// store a word of the kernel info page
+
 
 // Routines internal to the machine simulation -- DO NOT call these 
 
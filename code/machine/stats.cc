@@ -22,6 +22,8 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numSpaceSwitches = numSpaceSwitchesAvoided = 0;
+    numContextSwitches = numTimerInterrupts = 0;
 }
 
 //----------------------------------------------------------------------
@@ -39,6 +41,10 @@ Statistics::Print()
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
+    printf("Address spaces: switches %d, avoided %d\n", numSpaceSwitches,
+	numSpaceSwitchesAvoided);
+    printf("Scheduling: context switches %d, timer interrupts %d\n",
+	numContextSwitches, numTimerInterrupts);
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 }
@@ -35,6 +35,12 @@ class Statistics {
     int numPageFaults;		// number of virtual memory page faults
     int numPacketsSent;		// number of packets sent over the network
     int numPacketsRecvd;	// number of packets received over the network
+    int numSpaceSwitches;	// number of times a user address space was
+				// loaded in place of another
+    int numSpaceSwitchesAvoided; // number of times a user thread ran again
+				// with its address space still loaded
+    int numContextSwitches;	// number of times a different thread ran
+    int numTimerInterrupts;	// number of times the timer went off
 
     Statistics(); 		// initialize everything to zero
 
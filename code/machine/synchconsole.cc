@@ -1,6 +1,13 @@
-
+// synchconsole.cc
+//	Routines to synchronously access the console.  The physical
+//	console is an asynchronous device (requests return immediately,
+//	and an interrupt happens later on).  This is a layer on top of
+//	the console providing a synchronous interface (requests wait
+//	until the request completes), with line-buffered input and
+//	buffered output.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
-// All rights reserved.  See copyright.h for copyright notice and limitation 
+// All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
 
 #include "copyright.h"
@@ -9,42 +16,139 @@
 #include "console.h"
 #include <ctype.h>
 
-static Semaphore *readAvail;
-static Semaphore *writeDone;
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
 static const char *escapev = "\a\b\t\n\v\f\r\0";
 static const char *escapec = "abtnvfr0";
 
+//----------------------------------------------------------------------
+// ConsoleReadAvail, ConsoleWriteDone
+// 	Console interrupt handlers.  Need this to be a C routine, because
+//	C++ can't handle pointers to member functions.
+//----------------------------------------------------------------------
+
+static void ConsoleReadAvail(int arg) { ((SynchConsole *)arg)->ReadAvail(); }
+static void ConsoleWriteDone(int arg) { ((SynchConsole *)arg)->WriteDone(); }
+
+//----------------------------------------------------------------------
+// SynchConsole::SynchConsole
+// 	Initialize the synchronous interface to the console, in turn
+//	initializing the console.
+//
+//	"readFile" -- UNIX file simulating the keyboard (NULL -> use stdin)
+//	"writeFile" -- UNIX file simulating the display (NULL -> use stdout)
+//----------------------------------------------------------------------
+
 SynchConsole::SynchConsole(char *readFile, char *writeFile)
 {
-    readAvail = new Semaphore("read avail", 0);
-    writeDone = new Semaphore("write done", 0);
     lock = new Lock("synch console lock");
-    console = new Console(readFile, writeFile, ReadAvail, WriteDone, 0);
+    readLock = new Lock("synch console read lock");
+    lineAvail = new Semaphore("line avail", 0);
+    outSpace = new Semaphore("output space", 0);
+    writerWaiting = FALSE;
+    readerWaiting = FALSE;
+    reading = FALSE;
+    inHead = inCount = 0;
+    linesReady = 0;
+    inputHeld = inputEnded = FALSE;
+    outHead = outCount = outBusy = 0;
+    console = new Console(readFile, writeFile, NULL, ConsoleWriteDone,
+			  (int)this);	// no keyboard until the first read
 }
 
+//----------------------------------------------------------------------
+// SynchConsole::~SynchConsole
+// 	De-allocate data structures needed for the synchronous console
+//	abstraction.  Output still waiting for the display is written out
+//	directly, since Nachos is shutting down.
+//----------------------------------------------------------------------
+
 SynchConsole::~SynchConsole()
 {
+    int first = (outHead + outBusy) % ConsoleBufferSize;
+    int left = outCount - outBusy;	// the burst in progress is already
+					// on the host
+    int piece = min(left, ConsoleBufferSize - first);
+
+    if (piece > 0)
+	console->WriteNow(&outBuffer[first], piece);
+    if (left > piece)
+	console->WriteNow(outBuffer, left - piece);
+
     delete console;
     delete lock;
-    delete writeDone;
-    delete readAvail;
+    delete readLock;
+    delete lineAvail;
+    delete outSpace;
 }
 
+//----------------------------------------------------------------------
+// SynchConsole::PutChar
+// 	Queue a character for the display.
+//----------------------------------------------------------------------
+
 void SynchConsole::PutChar(char ch)
+{
+    Write(&ch, 1);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::Write
+// 	Queue "size" characters for the display, and return without
+//	waiting for them to be written -- unless the output buffer is
+//	full, in which case wait for the display to make room.  Holding
+//	"lock" throughout keeps the output of different writers from
+//	being interleaved.
+//----------------------------------------------------------------------
+
+void SynchConsole::Write(char *from, int size)
 {
     lock->Acquire();
-    console->PutChar(ch);
-    writeDone->P();
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);	// outBuffer is shared
+							// with WriteDone
+    for (int i = 0; i < size; i++) {
+	while (outCount == ConsoleBufferSize) {
+	    if (outBusy == 0)
+		StartOutput();
+	    writerWaiting = TRUE;
+	    outSpace->P();
+	}
+	outBuffer[(outHead + outCount) % ConsoleBufferSize] = from[i];
+	outCount++;
+    }
+    if (outBusy == 0)
+	StartOutput();
+    (void)interrupt->SetLevel(oldLevel);
     lock->Release();
 }
 
+//----------------------------------------------------------------------
+// SynchConsole::StartOutput
+// 	If there is output waiting, hand the display as much of it as is
+//	contiguous in the buffer, in a single burst.  Called with
+//	interrupts off, and only when the display is idle.
+//----------------------------------------------------------------------
+
+void SynchConsole::StartOutput()
+{
+    ASSERT(outBusy == 0);
+    if (outCount == 0)
+	return;
+    outBusy = min(outCount, ConsoleBufferSize - outHead);
+    console->PutChars(&outBuffer[outHead], outBusy);
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::GetChar
+// 	Return the next character of input, waiting for a line to be
+//	typed if need be, and echo what it was.  Return EOF at the end of
+//	the input.
+//----------------------------------------------------------------------
+
 char SynchConsole::GetChar()
 {
-    lock->Acquire();
-    readAvail->P();
-    char ch = console->GetChar();
+    char ch;
+
+    if (ReadLine(&ch, 1) == 0)
+        return EOF;
     if (isprint(ch))
         printf("\nGet char:'%c'\n", ch);
     else
@@ -53,7 +157,103 @@ char SynchConsole::GetChar()
         if (p)
             printf("\nGet char:'\\%c'\n", escapec[p - escapev]);
     }
-    lock->Release();
     return ch;
 }
 
+//----------------------------------------------------------------------
+// SynchConsole::ReadLine
+// 	Copy the next line of input, up to "size" characters of it, to
+//	"into", and return how many were copied.  Only the calling thread
+//	waits for the line to be typed.  If the line is longer than
+//	"size", the rest of it is handed out by the next call, without
+//	waiting.  A line that fills the whole buffer is handed out before
+//	its '\n' arrives, and at the end of the input so is the last line,
+//	with or without one.  Return 0 once the input is used up.
+//----------------------------------------------------------------------
+
+int SynchConsole::ReadLine(char *into, int size)
+{
+    int n = 0;
+
+    if (size <= 0)
+	return 0;
+    readLock->Acquire();
+    if (!reading) {
+	reading = TRUE;
+	console->StartInput(ConsoleReadAvail);
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);	// inBuffer is shared
+							// with ReadAvail
+    while (!LineReady()) {
+	readerWaiting = TRUE;
+	lineAvail->P();
+    }
+    while (n < size && inCount > 0) {
+	char ch = inBuffer[inHead];
+
+	inHead = (inHead + 1) % ConsoleBufferSize;
+	inCount--;
+	into[n++] = ch;
+	if (ch == '\n') {
+	    linesReady--;
+	    break;
+	}
+    }
+    if (inputHeld) {			// there is room for it now
+	inputHeld = FALSE;
+	ReadAvail();
+    }
+    (void)interrupt->SetLevel(oldLevel);
+
+    readLock->Release();
+    return n;
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::ReadAvail
+// 	Interrupt handler: a character has been typed, or the input has
+//	ended.  Add the character to the input buffer -- or, if the buffer
+//	is full, leave it in the device until a reader makes room -- and
+//	wake up the reader if there is now something for it.
+//----------------------------------------------------------------------
+
+void SynchConsole::ReadAvail()
+{
+    if (console->InputEnded())
+	inputEnded = TRUE;
+    else if (inCount == ConsoleBufferSize) {
+	inputHeld = TRUE;
+	return;
+    } else {
+	char ch = console->GetChar();
+
+	inBuffer[(inHead + inCount) % ConsoleBufferSize] = ch;
+	inCount++;
+	if (ch == '\n')
+	    linesReady++;
+    }
+    if (readerWaiting && LineReady()) {
+	readerWaiting = FALSE;
+	lineAvail->V();
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchConsole::WriteDone
+// 	Interrupt handler: the last burst is out.  Free its room in the
+//	buffer, wake up a writer waiting for room, and start on whatever
+//	has been queued in the meantime.
+//----------------------------------------------------------------------
+
+void SynchConsole::WriteDone()
+{
+    outHead = (outHead + outBusy) % ConsoleBufferSize;
+    outCount -= outBusy;
+    outBusy = 0;
+    if (writerWaiting) {
+	writerWaiting = FALSE;
+	outSpace->V();
+    }
+    StartOutput();
+}
@@ -1,22 +1,40 @@
-
+// synchconsole.h
+// 	Data structures to export a synchronous interface to the raw
+//	console device.
+//
 // Copyright (c) 1992-1993 The Regents of the University of California.
-// All rights reserved.  See copyright.h for copyright notice and limitation 
+// All rights reserved.  See copyright.h for copyright notice and limitation
 // of liability and disclaimer of warranty provisions.
 
+#ifndef SYNCHCONSOLE_H
+#define SYNCHCONSOLE_H
 
 #include "copyright.h"
 #include "utility.h"
 #include "console.h"
 #include "synch.h"
 
-// The following class defines a hardware console device.
-// Input and output to the device is simulated by reading 
-// and writing to UNIX files ("readFile" and "writeFile").
+#define ConsoleBufferSize 256	// characters of input typed ahead, and
+				// of output waiting for the display
+
+// The following class defines a "synchronous" console abstraction.
+// Threads asking for input wait on a semaphore until there is some,
+// while other threads (and interrupts) carry on.
 //
-// Since the device is asynchronous, the interrupt handler "readAvail" 
-// is called when a character has arrived, ready to be read in.
-// The interrupt handler "writeDone" is called when an output character 
-// has been "put", so that the next character can be written.
+// Input is line-buffered: the read interrupt handler collects the
+// characters typed into a ring buffer, and a reader is only woken once
+// a whole line ('\n' and all) has arrived.  A line too long for the
+// buffer is handed out a bufferful at a time; while the buffer is full,
+// further characters are left waiting in the device, so none are lost.
+// At the end of the input, a reader gets whatever is left of the last
+// line, even without a '\n', and from then on reads return 0.  The
+// keyboard is not polled until the first read, because the polling
+// would keep the machine from ever going idle.
+//
+// Output is buffered too: writers only wait if the output buffer is
+// full.  Whatever has collected in the buffer is handed to the display
+// in one burst, one interrupt (and one host write) per burst rather
+// than per character.
 
 class SynchConsole {
   public:
@@ -25,17 +43,55 @@ class SynchConsole {
     ~SynchConsole();			// clean up console emulation
 
 // external interface -- Nachos kernel code can call these
-    void PutChar(char ch);	// Write "ch" to the console display, 
-				// and return immediately.  "writeHandler" 
-				// is called when the I/O completes. 
+    void PutChar(char ch);	// Queue "ch" for the console display
+    void Write(char *from, int size);
+				// Queue "size" characters for the display,
+				// waiting only for room in the buffer
+
+    char GetChar();	   	// Return the next character of input,
+				// waiting for a line if there is none;
+				// EOF at the end of the input
 
-    char GetChar();	   	// Poll the console input.  If a char is 
-				// available, return it.  Otherwise, return EOF.
-    				// "readHandler" is called whenever there is 
-				// a char to be gotten
+    int ReadLine(char *into, int size);
+				// Wait for a line of input, and copy up to
+				// "size" characters of it (including the
+				// '\n') to "into".  What does not fit is
+				// returned by the next call.  Return 0 at
+				// the end of the input.
+
+// interrupt handlers -- called by the console device
+    void ReadAvail();		// a character has been typed
+    void WriteDone();		// the last burst of output is out
 
   private:
-    Console *console;    	
-	Lock *lock;	
+    Console *console;
+    Lock *lock;			// one writer at a time
+    Lock *readLock;		// one reader at a time
+    Semaphore *lineAvail;	// V'ed when there is a line for the reader
+    bool readerWaiting;		// the reader is waiting on "lineAvail"
+    Semaphore *outSpace;	// V'ed when room is made for a writer
+    bool writerWaiting;		// a writer is waiting on "outSpace"
+    bool reading;		// the keyboard is being polled
+
+    char inBuffer[ConsoleBufferSize];	// characters typed, in a ring
+    int inHead;			// next character to hand out
+    int inCount;		// characters in "inBuffer"
+    int linesReady;		// '\n's in "inBuffer"
+    bool inputHeld;		// a character is waiting in the device for
+				// room in "inBuffer"
+    bool inputEnded;		// the keyboard file has run out
+
+    bool LineReady()		// is there something for a reader?
+	{ return linesReady > 0 || inputEnded ||
+		 inCount == ConsoleBufferSize; }
+
+    void StartOutput();		// hand the display the next burst
+
+    char outBuffer[ConsoleBufferSize];	// output queued, in a ring
+    int outHead;		// first character not yet out
+    int outCount;		// characters in "outBuffer"
+    int outBusy;		// how many of them the display is writing
+				// now, 0 if it is idle
 };
 
+#endif // SYNCHCONSOLE_H
@@ -464,10 +464,15 @@ Random()
 //----------------------------------------------------------------------
 // AllocBoundedArray
 // 	Return an array, with the two pages just before 
-//	and after the array unmapped, to catch illegal references off
-//	the end of the array.  Particularly useful for catching overflow
+//	and after the array made inaccessible, to catch illegal references
+//	off the end of the array.  Particularly useful for catching overflow
 //	beyond fixed-size thread execution stacks.
 //
+//	The array is mapped by itself, page-aligned, so that the guard
+//	pages are not shared with anything else.  If "size" is not a
+//	multiple of the page size, the guard after the array starts at
+//	the next page boundary.
+//
 //	Note: Just return the useful part!
 //
 //	"size" -- amount of useful space needed (in bytes)
@@ -477,16 +482,21 @@ char *
 AllocBoundedArray(int size)
 {
     int pgSize = getpagesize();
-    char *ptr = new char[pgSize * 2 + size];
-
-    //mprotect(ptr, pgSize, 0);
-    //mprotect(ptr + pgSize + size, pgSize, 0);
+    int useful = divRoundUp(size, pgSize) * pgSize;
+    char *ptr = (char *) mmap(NULL, pgSize * 2 + useful,
+			PROT_READ | PROT_WRITE | PROT_EXEC,
+			MAP_PRIVATE | MAP_ANON, -1, 0);
+
+    ASSERT(ptr != (char *) MAP_FAILED);
+    mprotect(ptr, pgSize, PROT_NONE);
+    mprotect(ptr + pgSize + useful, pgSize, PROT_NONE);
     return ptr + pgSize;
 }
 
 //----------------------------------------------------------------------
 // DeallocBoundedArray
-// 	Deallocate an array of integers, unprotecting its two boundary pages.
+// 	Deallocate an array allocated by AllocBoundedArray, along with
+//	its two boundary pages.
 //
 //	"ptr" -- the array to be deallocated
 //	"size" -- amount of useful space in the array (in bytes)
@@ -496,8 +506,7 @@ void
 DeallocBoundedArray(char *ptr, int size)
 {
     int pgSize = getpagesize();
+    int useful = divRoundUp(size, pgSize) * pgSize;
 
-    mprotect(ptr - pgSize, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    mprotect(ptr + size, pgSize, PROT_READ | PROT_WRITE | PROT_EXEC);
-    delete [] (ptr - pgSize);
+    munmap(ptr - pgSize, pgSize * 2 + useful);
 }
@@ -5,7 +5,8 @@
 //      This means it can be used for implementing time-slicing.
 //
 //      We emulate a hardware timer by scheduling an interrupt to occur
-//      every time stats->totalTicks has increased by TimerTicks.
+//      when stats->totalTicks has increased by the amount asked for.
+//	The timer only goes off once for each Start.
 //
 //      In order to introduce some randomness into time-slicing, if "doRandom"
 //      is set, then the interrupt is comes after a random number of ticks.
@@ -30,8 +31,7 @@ static void TimerHandler(int arg)
 //----------------------------------------------------------------------
 // Timer::Timer
 //      Initialize a hardware timer device.  Save the place to call
-//	on each interrupt, and then arrange for the timer to start
-//	generating interrupts.
+//	on each interrupt.  The timer does not run until Start is called.
 //
 //      "timerHandler" is the interrupt handler for the timer device.
 //		It is called with interrupts disabled every time the
@@ -46,24 +46,46 @@ Timer::Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom)
     randomize = doRandom;
     handler = timerHandler;
     arg = callArg; 
+    next = 0;
+}
 
-    // schedule the first interrupt from the timer device
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt); 
+//----------------------------------------------------------------------
+// Timer::Start
+//      Arrange for the timer to go off "fromNow" ticks from now, or
+//	after a random delay if randomize is turned on.  If it is already
+//	running, leave it be.
+//----------------------------------------------------------------------
+void
+Timer::Start(int fromNow)
+{
+    if (next == 0)
+	next = interrupt->Schedule(TimerHandler, (int) this,
+			TimeOfNextInterrupt(fromNow), TimerInt);
+}
+
+//----------------------------------------------------------------------
+// Timer::Stop
+//      Cancel the interrupt the timer was going to generate, if any.
+//----------------------------------------------------------------------
+void
+Timer::Stop()
+{
+    if (next != 0)
+	(void) interrupt->Cancel(next);
+    next = 0;
 }
 
 //----------------------------------------------------------------------
 // Timer::TimerExpired
 //      Routine to simulate the interrupt generated by the hardware 
-//	timer device.  Schedule the next interrupt, and invoke the
-//	interrupt handler.
+//	timer device.  The timer is now stopped; invoke the interrupt
+//	handler, which may start it again.
 //----------------------------------------------------------------------
 void 
 Timer::TimerExpired() 
 {
-    // schedule the next timer device interrupt
-    interrupt->Schedule(TimerHandler, (int) this, TimeOfNextInterrupt(), 
-		TimerInt);
+    next = 0;
+    stats->numTimerInterrupts++;
 
     // invoke the Nachos interrupt handler for this device
     (*handler)(arg);
@@ -71,15 +93,16 @@ Timer::TimerExpired()
 
 //----------------------------------------------------------------------
 // Timer::TimeOfNextInterrupt
-//      Return when the hardware timer device will next cause an interrupt.
-//	If randomize is turned on, make it a (pseudo-)random delay.
+//      Return when the hardware timer device will next cause an interrupt:
+//	"fromNow" ticks from now, unless randomize is turned on, in which
+//	case make it a (pseudo-)random delay.
 //----------------------------------------------------------------------
 
 int 
-Timer::TimeOfNextInterrupt() 
+Timer::TimeOfNextInterrupt(int fromNow) 
 {
     if (randomize)
 	return 1 + (Random() % (TimerTicks * 2));
     else
-	return TimerTicks; 
+	return fromNow; 
 }
@@ -6,7 +6,10 @@
 //	having a thread go to sleep for a specific period of time. 
 //
 //	We emulate a hardware timer by scheduling an interrupt to occur
-//	every time stats->totalTicks has increased by TimerTicks.
+//	when stats->totalTicks has increased by the amount asked for.  The
+//	timer is one-shot: once it goes off, it stays quiet until it is
+//	started again, so that nobody is interrupted for nothing when
+//	there is no other thread to switch to.
 //
 //	In order to introduce some randomness into time-slicing, if "doRandom"
 //	is set, then the interrupt comes after a random number of ticks.
@@ -28,21 +31,29 @@ class Timer {
   public:
     Timer(VoidFunctionPtr timerHandler, int callArg, bool doRandom);
 				// Initialize the timer, to call the interrupt
-				// handler "timerHandler" every time slice.
+				// handler "timerHandler" when it expires.
+				// It starts out stopped.
     ~Timer() {}
 
+    void Start(int fromNow);	// Go off in "fromNow" ticks (or at random),
+				// unless already running
+    void Stop();		// Don't go off after all
+    bool IsRunning() { return (next != 0); }
+
 // Internal routines to the timer emulation -- DO NOT call these
 
     void TimerExpired();	// called internally when the hardware
 				// timer generates an interrupt
 
-    int TimeOfNextInterrupt();  // figure out when the timer will generate
-				// its next interrupt 
+    int TimeOfNextInterrupt(int fromNow); // figure out when the timer will
+				// generate its next interrupt 
 
   private:
     bool randomize;		// set if we need to use a random timeout delay
     VoidFunctionPtr handler;	// timer interrupt handler 
     int arg;			// argument to pass to interrupt handler
+    int next;			// handle of the pending interrupt, 0 if
+				// the timer is stopped
 
 };
 
@@ -212,6 +212,20 @@ Machine::Translate(int virtAddr, int *physAddr, int size, bool writing)
 	vpn = (unsigned)virtAddr / PageSize;
 	offset = (unsigned)virtAddr % PageSize;
 
+	// the kernel info page is mapped into every address space, outside
+	// the page table and the TLB
+	if (vpn == KernelInfoAddr / PageSize)
+	{
+		if (writing)
+		{
+			DEBUG('a', "write to the kernel info page!\n");
+			return ReadOnlyException;
+		}
+		*physAddr = KernelInfoFrame * PageSize + offset;
+		DEBUG('a', "kernel info page, phys addr = 0x%x\n", *physAddr);
+		return NoException;
+	}
+
 	if (tlb == NULL)
 	{ // => page table => vpn is index into table
 		if (vpn >= pageTableSize)
@@ -44,6 +44,8 @@ class TranslationEntry {
     long long interval; // Time interval since last used.
     bool replace;
     bool noSwap;
+    bool zeroFill;	// Heap page never written back: fill it with
+			// zeroes instead of reading the swap file.
     /* lab4 end */
 };
 
@@ -0,0 +1,55 @@
+/* aio.c
+ *	Test program for asynchronous I/O.
+ *
+ *	Write a file, then read it back double-buffered: while one chunk
+ *	is being checked, the next is already on its way from the disk.
+ *	Exits with the number of mismatched bytes.
+ */
+
+#include "syscall.h"
+
+#define CHUNK 512
+#define NCHUNKS 16
+
+char data[CHUNK];
+char buf[2][CHUNK];
+char fname[4] = "aio";
+
+int main()
+{
+	AioId req[2], writes[NCHUNKS];
+	int fd, i, n, cur, errors = 0;
+
+	for (i = 0; i < CHUNK; i++)
+		data[i] = 'a' + i % 26;
+
+	Create(fname);
+	fd = Open(fname);
+	for (n = 0; n < NCHUNKS; n++)
+		writes[n] = AioWrite(data, CHUNK, fd);
+	for (n = 0; n < NCHUNKS; n++)
+	{
+		AioWait(&writes[n], 1);
+		if (AioPoll(writes[n]) != CHUNK)
+			errors++;
+	}
+	Close(fd);
+
+	fd = Open(fname);
+	req[0] = AioRead(buf[0], CHUNK, fd);
+	for (n = 0; n < NCHUNKS; n++)
+	{
+		cur = n % 2;
+		if (n + 1 < NCHUNKS)
+			req[!cur] = AioRead(buf[!cur], CHUNK, fd);
+		AioWait(&req[cur], 1);
+		if (AioPoll(req[cur]) != CHUNK)
+			errors++;
+		for (i = 0; i < CHUNK; i++)
+			if (buf[cur][i] != data[i])
+				errors++;
+	}
+	Close(fd);
+
+	Exit(errors);
+}
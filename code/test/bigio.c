@@ -0,0 +1,60 @@
+/* bigio.c
+ *	Test program for large and vectored file I/O.
+ *
+ *	Write a file larger than a thread's kernel stack with WriteV, read
+ *	it back with one big Read and with ReadV, and check the contents.
+ *	Exits with the number of mismatched bytes.
+ */
+
+#include "syscall.h"
+
+#define SIZE 20000
+
+char out[SIZE];
+char in[SIZE];
+char fname[6] = "bigio";
+
+int main()
+{
+	IoVec iov[3];
+	int fd, i, errors = 0;
+
+	for (i = 0; i < SIZE; i++)
+		out[i] = 'a' + i % 26;
+
+	Create(fname);
+	fd = Open(fname);
+	iov[0].buffer = out;
+	iov[0].size = 100;
+	iov[1].buffer = out + 100;
+	iov[1].size = 7000;
+	iov[2].buffer = out + 7100;
+	iov[2].size = SIZE - 7100;
+	if (WriteV(iov, 3, fd) != SIZE)
+		errors++;
+	Close(fd);
+
+	fd = Open(fname);
+	if (Read(in, SIZE, fd) != SIZE)
+		errors++;
+	Close(fd);
+	for (i = 0; i < SIZE; i++)
+		if (in[i] != out[i])
+			errors++;
+
+	for (i = 0; i < SIZE; i++)
+		in[i] = 0;
+	fd = Open(fname);
+	iov[0].buffer = in;
+	iov[0].size = 333;
+	iov[1].buffer = in + 333;
+	iov[1].size = SIZE - 333;
+	if (ReadV(iov, 2, fd) != SIZE)
+		errors++;
+	Close(fd);
+	for (i = 0; i < SIZE; i++)
+		if (in[i] != out[i])
+			errors++;
+
+	Exit(errors);
+}
@@ -0,0 +1,30 @@
+/* ckpt.c
+ *	Test program for checkpoint and restore.
+ *
+ *	Checkpoint the process, then change its memory, and Exec the
+ *	checkpoint: the restored copy must see the memory as it was at
+ *	the checkpoint.  Exits with 0 if it did.
+ */
+
+#include "syscall.h"
+
+int value;
+char name[] = "ckpt.img";
+
+int main()
+{
+	int result;
+
+	value = 1234;
+	result = Checkpoint(name);
+	if (result == 1)		/* restored: we are the copy */
+		Exit(value == 1234 ? 0 : 1);
+	if (result == -1)
+		Exit(-1);
+
+	value = 0;
+	result = Exec(name);
+	if (result == -1)
+		Exit(-1);
+	Exit(Join(result));
+}
@@ -0,0 +1,47 @@
+/* heap.c
+ *	Test program for Sbrk and the user-level malloc.
+ *
+ *	Sort arrays whose size is only known at run time, freeing each one
+ *	before allocating the next; then check that the freed memory was
+ *	reused rather than the heap growing without bound.  Exits with the
+ *	number of errors found.
+ */
+
+#include "syscall.h"
+#include "malloc.h"
+
+int main()
+{
+	int n, i, j, tmp, errors = 0;
+	int *a;
+	char *top;
+
+	for (n = 64; n <= 1024; n *= 2)
+	{
+		a = (int *)malloc(n * sizeof(int));
+		if (a == 0)
+			Exit(-1);
+		for (i = 0; i < n; i++)
+			a[i] = n - i;
+		for (i = 0; i < n - 1; i++)
+			for (j = 0; j < n - 1 - i; j++)
+				if (a[j] > a[j + 1])
+				{
+					tmp = a[j];
+					a[j] = a[j + 1];
+					a[j + 1] = tmp;
+				}
+		for (i = 0; i < n; i++)
+			if (a[i] != i + 1)
+				errors++;
+		free(a);
+	}
+
+	top = (char *)Sbrk(0);
+	for (i = 0; i < 16; i++)
+		free(malloc(4096));
+	if ((char *)Sbrk(0) != top)
+		errors++;
+
+	Exit(errors);
+}
@@ -0,0 +1,42 @@
+/* info.c
+ *	Test program for the kernel info page.
+ *
+ *	Time a loop with the tick counter from the info page, which takes
+ *	no system calls, and check that the page can be read in every
+ *	thread of the process.  Exits with the number of errors found.
+ */
+
+#include "syscall.h"
+
+int errors, childTid, childDone;
+
+void child()
+{
+	childTid = KernelInfoPtr->tid;
+	childDone = 1;
+	Exit(0);
+}
+
+int main()
+{
+	int i, start, sum = 0;
+	int pid = KernelInfoPtr->pid;
+	int tid = KernelInfoPtr->tid;
+
+	start = KernelInfoPtr->ticks;
+	for (i = 0; i < 1000; i++)
+		sum += i;
+	if (KernelInfoPtr->ticks - start < 1000)	/* at least a tick an instruction */
+		errors++;
+	if (KernelInfoPtr->cpu != 0 || sum != 499500)
+		errors++;
+
+	if (Fork(child) == -1)
+		Exit(-1);
+	while (!childDone)
+		Yield();
+	if (childTid == tid || KernelInfoPtr->pid != pid || KernelInfoPtr->tid != tid)
+		errors++;
+
+	Exit(errors);
+}
@@ -0,0 +1,106 @@
+/* malloc.c
+ *	A first-fit storage allocator for user programs.
+ *
+ *	Every block starts with a header giving its size (header included,
+ *	always a multiple of 8).  Free blocks are kept on a list sorted by
+ *	address, so that free can merge a block with its free neighbours.
+ *	When no free block is big enough, the heap is grown with Sbrk, at
+ *	least MinGrow bytes at a time; the kernel only hands out physical
+ *	pages as they are touched, so growing generously costs little.
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#include "syscall.h"
+#include "malloc.h"
+
+#define Align		8
+#define MinGrow		1024
+
+typedef struct Header {
+    int size;			/* bytes in this block, header included */
+    struct Header *next;	/* next free block, in address order */
+} Header;
+
+static Header *freeList = 0;
+
+/* Put "block" on the free list, merging it with the blocks on either
+ * side if they are free too.
+ */
+static void
+Release(Header *block)
+{
+    Header *prev = 0, *cur = freeList;
+
+    while (cur != 0 && cur < block) {
+	prev = cur;
+	cur = cur->next;
+    }
+
+    if (cur != 0 && (char *)block + block->size == (char *)cur) {
+	block->size += cur->size;
+	block->next = cur->next;
+    } else
+	block->next = cur;
+
+    if (prev != 0 && (char *)prev + prev->size == (char *)block) {
+	prev->size += block->size;
+	prev->next = block->next;
+    } else if (prev != 0)
+	prev->next = block;
+    else
+	freeList = block;
+}
+
+/* Get at least "size" more bytes from the kernel onto the free list. */
+static int
+Grow(int size)
+{
+    Header *block;
+
+    if (size < MinGrow)
+	size = MinGrow;
+    block = (Header *)Sbrk(size);
+    if ((int)block == -1)
+	return 0;
+    block->size = size;
+    Release(block);
+    return 1;
+}
+
+void *
+malloc(int size)
+{
+    Header *prev, *cur;
+
+    if (size <= 0)
+	return 0;
+    size = (size + sizeof(Header) + Align - 1) & ~(Align - 1);
+
+    for (;;) {
+	for (prev = 0, cur = freeList; cur != 0; prev = cur, cur = cur->next)
+	    if (cur->size >= size) {
+		if (cur->size - size >= (int)sizeof(Header) + Align) {
+		    /* split: hand out the tail */
+		    cur->size -= size;
+		    cur = (Header *)((char *)cur + cur->size);
+		    cur->size = size;
+		} else if (prev != 0)
+		    prev->next = cur->next;
+		else
+		    freeList = cur->next;
+		return (void *)(cur + 1);
+	    }
+	if (!Grow(size))
+	    return 0;
+    }
+}
+
+void
+free(void *ptr)
+{
+    if (ptr != 0)
+	Release((Header *)ptr - 1);
+}
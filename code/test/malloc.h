@@ -0,0 +1,21 @@
+/* malloc.h
+ *	A small storage allocator for Nachos user programs, on top of the
+ *	Sbrk system call.  Link malloc.o right after start.o to use it.
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#ifndef MALLOC_H
+#define MALLOC_H
+
+/* Return "size" bytes of fresh, 8-byte aligned memory, or 0 if the
+ * heap is exhausted.
+ */
+void *malloc(int size);
+
+/* Give back memory returned by malloc.  free(0) does nothing. */
+void free(void *ptr);
+
+#endif /* MALLOC_H */
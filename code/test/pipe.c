@@ -0,0 +1,56 @@
+/* pipe.c
+ *	Test program for MakePipe.
+ *
+ *	A Fork'ed thread writes a numbered stream of bytes into a pipe in
+ *	odd-sized pieces, then closes its end.  The main thread reads it
+ *	back in large pieces until end of file, checking that every byte
+ *	arrives once and in order, and that each read takes whole Writes
+ *	rather than a byte at a time.  Exits with the number of
+ *	errors found.
+ */
+
+#include "syscall.h"
+
+#define StreamSize 16384
+#define WriteSize 1000
+
+OpenFileId fds[2];
+char out[WriteSize], in[8192];
+
+void writer()
+{
+	int sent = 0, i, n;
+
+	while (sent < StreamSize) {
+		n = StreamSize - sent;
+		if (n > WriteSize)
+			n = WriteSize;
+		for (i = 0; i < n; i++)
+			out[i] = (sent + i) % 251;
+		Write(out, n, fds[1]);
+		sent += n;
+	}
+	Close(fds[1]);		/* the reader sees end of file */
+	Exit(0);
+}
+
+int main()
+{
+	int errors = 0, got = 0, reads = 0, i, n;
+
+	if (MakePipe(fds) == -1 || Fork(writer) == -1)
+		Exit(-1);
+	while ((n = Read(in, 8192, fds[0])) > 0) {
+		for (i = 0; i < n; i++)
+			if (in[i] != (char)((got + i) % 251))
+				errors++;
+		got += n;
+		reads++;
+	}
+	if (got != StreamSize)
+		errors++;
+	if (reads > StreamSize / WriteSize + 1)	/* never part of a Write */
+		errors++;
+	Close(fds[0]);
+	Exit(errors);
+}
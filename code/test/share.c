@@ -0,0 +1,40 @@
+/* share.c
+ *	Test program for proportional-share scheduling.
+ *
+ *	Run with "-sched stride".  The main thread holds three times as
+ *	many tickets as a thread it Forks; both count for the same stretch
+ *	of simulated time.  Exits with ten times the ratio of their counts,
+ *	which should come out near 30.
+ */
+
+#include "syscall.h"
+
+#define RunTicks	20000
+
+int deadline, childCount, childDone;
+
+void child()
+{
+	SetShare(100);
+	while (KernelInfoPtr->ticks < deadline)
+		childCount++;
+	childDone = 1;
+	Exit(0);
+}
+
+int main()
+{
+	int count = 0;
+
+	SetShare(300);
+	deadline = KernelInfoPtr->ticks + RunTicks;
+	if (Fork(child) == -1)
+		Exit(-1);
+	while (KernelInfoPtr->ticks < deadline)
+		count++;
+	while (!childDone)
+		Yield();
+	if (childCount == 0)
+		Exit(-1);
+	Exit(10 * count / childCount);
+}
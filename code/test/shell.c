@@ -1,15 +1,21 @@
 #include "syscall.h"
 
+DirEnt entries[8];
+char cpUsage[] = "usage: cp <from> <to>\n";
+
 int main()
 {
 	SpaceId newProc;
 	OpenFileId input = ConsoleInput;
 	OpenFileId output = ConsoleOutput;
 	char prompt[2], ch, buffer[60];
-	char endl[1];
+	char endl[1], slash[1], dot[2];
 	int len;
 
 	endl[0] = '\n';
+	slash[0] = '/';
+	dot[0] = '.';
+	dot[1] = '\0';
 	prompt[0] = '$';
 	prompt[1] = ' ';
 	
@@ -18,14 +24,10 @@ int main()
 	{
 		Write(prompt, 3, output);
 
-		len = 0;
-
-		do
-		{
-			Read(&buffer[len], 1, input);
-		} while (buffer[len++] != '\n');
-
-		buffer[--len] = '\0';
+		len = Read(buffer, 59, input); /* one whole line */
+		if (len > 0 && buffer[len - 1] == '\n')
+			len--;
+		buffer[len] = '\0';
 
 		if (buffer[0] == 'e' && buffer[1] == 'c')
 		{
@@ -35,21 +37,59 @@ int main()
 		else if (buffer[0] == 'e' && buffer[1] == 'x')
 			Exit(0);
 		else if (buffer[0] == 'l')
-			Ls();
+		{
+			OpenFileId dir = Open(dot);
+			int i, n;
+			while ((n = ReadDir(dir, entries, 8)) > 0)
+				for (i = 0; i < n; ++i)
+				{
+					for (len = 0; entries[i].name[len] != '\0'; ++len) {};
+					Write(entries[i].name, len, output);
+					if (entries[i].isDir)
+						Write(slash, 1, output);
+					Write(endl, 1, output);
+				}
+			Close(dir);
+		}
 		else if (buffer[0] == 'p' && buffer[1] == 'w')
-			Pwd();
+		{
+			if ((len = GetCwd(buffer, 60)) > 0)
+				Write(buffer, len, output);
+			Write(endl, 1, output);
+		}
 		else if (buffer[0] == 'p' && buffer[1] == 's')
 			Ps();
+		else if (buffer[0] == 'c' && buffer[1] == 'p')
+		{
+			int i, j;
+			OpenFileId src, dst;
+			for (i = 0; buffer[i] != ' ' && buffer[i] != '\0'; ++i) {};
+			j = i;
+			if (buffer[i] != '\0')
+				for (j = i + 1; buffer[j] != ' ' && buffer[j] != '\0'; ++j) {};
+			if (buffer[j] == '\0' || buffer[j + 1] == '\0')
+			{ /* fewer than two names */
+				Write(cpUsage, sizeof(cpUsage) - 1, output);
+				continue;
+			}
+			buffer[j] = '\0';
+			src = Open(buffer + i + 1);
+			Create(buffer + j + 1);
+			dst = Open(buffer + j + 1);
+			CopyFile(src, dst, 0, 0x7fffffff);
+			Close(src);
+			Close(dst);
+		}
 		else if (buffer[0] == 'c')
 		{
 			int i;
-			for (i = 0; buffer[i] != ' '; ++i) {};
-			Chdir(buffer + i + 1);
+			for (i = 0; buffer[i] != ' ' && buffer[i] != '\0'; ++i) {};
+			if (buffer[i] != '\0')
+				Chdir(buffer + i + 1);
 		}
 		else if (len > 0)
 		{
 			newProc = Exec(buffer);
-			Yield();
 			Join(newProc);
 		}
 	}
@@ -0,0 +1,43 @@
+/* sleep.c
+ *	Test program for Sleep.
+ *
+ *	The main thread and a thread it Forks sleep for different times.
+ *	Each must be woken no sooner than it asked, and the shorter sleep
+ *	must end first.  Exits with the number of errors found.
+ */
+
+#include "syscall.h"
+
+int errors, wokenFirst, childDone;
+
+void child()
+{
+	int start = KernelInfoPtr->ticks;
+
+	Sleep(500);
+	if (KernelInfoPtr->ticks - start < 500)
+		errors++;
+	if (wokenFirst == 0)
+		wokenFirst = 2;
+	childDone = 1;
+	Exit(0);
+}
+
+int main()
+{
+	int start;
+
+	if (Fork(child) == -1)
+		Exit(-1);
+	start = KernelInfoPtr->ticks;
+	Sleep(2000);
+	if (KernelInfoPtr->ticks - start < 2000)
+		errors++;
+	if (wokenFirst == 0)
+		wokenFirst = 1;
+	while (!childDone)
+		Yield();
+	if (wokenFirst != 2)
+		errors++;
+	Exit(errors);
+}
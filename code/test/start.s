@@ -130,21 +130,21 @@ Yield:
 	j	$31
 	.end Yield
 
-	.globl Ls
-	.ent	Ls
-Ls:
-	addiu $2,$0,SC_Ls
+	.globl ReadDir
+	.ent	ReadDir
+ReadDir:
+	addiu $2,$0,SC_ReadDir
 	syscall
 	j	$31
-	.end Ls
+	.end ReadDir
 
-	.globl Pwd
-	.ent	Pwd
-Pwd:
-	addiu $2,$0,SC_Pwd
+	.globl GetCwd
+	.ent	GetCwd
+GetCwd:
+	addiu $2,$0,SC_GetCwd
 	syscall
 	j	$31
-	.end Ls
+	.end GetCwd
 
 	.globl Chdir
 	.ent	Chdir
@@ -162,6 +162,102 @@ Ps:
 	j	$31
 	.end Ps
 
+	.globl ReadV
+	.ent	ReadV
+ReadV:
+	addiu $2,$0,SC_ReadV
+	syscall
+	j	$31
+	.end ReadV
+
+	.globl WriteV
+	.ent	WriteV
+WriteV:
+	addiu $2,$0,SC_WriteV
+	syscall
+	j	$31
+	.end WriteV
+
+	.globl CopyFile
+	.ent	CopyFile
+CopyFile:
+	addiu $2,$0,SC_CopyFile
+	syscall
+	j	$31
+	.end CopyFile
+
+	.globl AioRead
+	.ent	AioRead
+AioRead:
+	addiu $2,$0,SC_AioRead
+	syscall
+	j	$31
+	.end AioRead
+
+	.globl AioWrite
+	.ent	AioWrite
+AioWrite:
+	addiu $2,$0,SC_AioWrite
+	syscall
+	j	$31
+	.end AioWrite
+
+	.globl AioPoll
+	.ent	AioPoll
+AioPoll:
+	addiu $2,$0,SC_AioPoll
+	syscall
+	j	$31
+	.end AioPoll
+
+	.globl AioWait
+	.ent	AioWait
+AioWait:
+	addiu $2,$0,SC_AioWait
+	syscall
+	j	$31
+	.end AioWait
+
+	.globl Sbrk
+	.ent	Sbrk
+Sbrk:
+	addiu $2,$0,SC_Sbrk
+	syscall
+	j	$31
+	.end Sbrk
+
+	.globl Checkpoint
+	.ent	Checkpoint
+Checkpoint:
+	addiu $2,$0,SC_Checkpoint
+	syscall
+	j	$31
+	.end Checkpoint
+
+	.globl SetShare
+	.ent	SetShare
+SetShare:
+	addiu $2,$0,SC_SetShare
+	syscall
+	j	$31
+	.end SetShare
+
+	.globl Sleep
+	.ent	Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
+	.globl MakePipe
+	.ent	MakePipe
+MakePipe:
+	addiu $2,$0,SC_MakePipe
+	syscall
+	j	$31
+	.end MakePipe
+
 /* dummy function to keep gcc happy */
         .globl  __main
         .ent    __main
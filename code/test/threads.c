@@ -0,0 +1,65 @@
+/* threads.c
+ *	Test program for user threads.
+ *
+ *	Split a sum over several threads of one process.  The threads
+ *	share the array and the results in global memory, and Yield to
+ *	each other all the way through; each keeps its running sum in a
+ *	local variable, which only survives if every thread has a stack
+ *	of its own.  Exits with 0 if the total comes out right.
+ *
+ *	There are no user-level locks, and the timer may preempt a thread
+ *	anywhere, so no variable is incremented by more than one thread:
+ *	main hands each worker its index and waits for it to be taken,
+ *	and each worker reports back in a flag of its own.
+ */
+
+#include "syscall.h"
+
+#define NumWorkers	4
+#define N		1024
+
+int data[N];
+int partial[NumWorkers], done[NumWorkers];
+int nextWorker, taken;
+
+void worker()
+{
+	int me = nextWorker;
+	int i, sum = 0;
+
+	taken = 1;
+
+	for (i = me; i < N; i += NumWorkers)
+	{
+		sum += data[i];
+		if (i % 64 == me)
+			Yield();
+	}
+	partial[me] = sum;
+	done[me] = 1;
+	Exit(0);
+}
+
+int main()
+{
+	int i, total = 0;
+
+	for (i = 0; i < N; i++)
+		data[i] = i;
+	for (i = 0; i < NumWorkers; i++)
+	{
+		nextWorker = i;
+		taken = 0;
+		if (Fork(worker) == -1)
+			Exit(-1);
+		while (!taken)
+			Yield();
+	}
+	for (i = 0; i < NumWorkers; i++)
+	{
+		while (!done[i])
+			Yield();
+		total += partial[i];
+	}
+	Exit(total != N * (N - 1) / 2);
+}
@@ -8,22 +8,27 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
-//		-s -x <nachos file> -c <consoleIn> <consoleOut>
+// Usage: nachos -d <debugflags> -rs <random seed #> -sched <policy>
+//		-sc <stacks cached>
+//		-s -x <nachos file> -c <consoleIn> <consoleOut> -st <trace file>
 //		-f -cp <unix file> <nachos file>
-//		-p <nachos file> -r <nachos file> -l -D -t
+//		-p <nachos file> -r <nachos file> -l -D -t -tr
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -sched picks the scheduling policy: "fifo" (the default), "mlfq"
+//	or "stride"
+//    -sc sets how many thread stacks are kept for reuse (default 16)
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
 //    -s causes user programs to be executed in single-step mode
 //    -x runs a user program
 //    -c tests the console
+//    -st writes a binary trace of every system call (see bin/tracedump)
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
@@ -33,6 +38,7 @@
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system
 //    -t tests the performance of the Nachos file system
+//    -tr tests several threads reading one file at once
 //
 //  NETWORK
 //    -n sets the network reliability
@@ -60,7 +66,7 @@ extern int testnum;
 // External functions used by this file
 
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
-extern void Print(char *file), PerformanceTest(void);
+extern void Print(char *file), PerformanceTest(void), ReadTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out), SynchConsoleTest(char *in, char *out), TestMultiProcess(), PipeTest();
 extern void MailTest(int networkID);
 extern void PrintHello();
@@ -172,6 +178,10 @@ int main(int argc, char **argv)
 			//PerformanceTest();
 			PipeTest();
 		}
+		else if (!strcmp(*argv, "-tr"))
+		{ // concurrent read test
+			ReadTest();
+		}
 #endif // FILESYS
 #ifdef NETWORK
 		if (!strcmp(*argv, "-o"))
@@ -1,35 +1,140 @@
+// pipe.cc
+//	Routines to move bytes through a pipe.  See pipe.h.
+//
+//	The buffer is a ring: "head" is the oldest unread byte, and the
+//	"count" bytes after it (wrapping at PipeSize) are unread.  Every
+//	transfer is done as at most two bcopy's -- the piece up to the end
+//	of the buffer, and the piece that wraps around to the start.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "pipe.h"
 #include "system.h"
 
+//----------------------------------------------------------------------
+// Pipe::Pipe
+// 	Initialize an empty pipe, with no ends open yet.
+//----------------------------------------------------------------------
+
 Pipe::Pipe()
 {
-    pos = 0;
-    cond = new Condition("pipe cond");
-    full = new Lock("full lock");
-    empty = new Lock("empty lock");
+    head = count = 0;
+    readers = writers = 0;
+    lock = new Lock("pipe lock");
+    dataAvail = new Condition("pipe data");
+    roomAvail = new Condition("pipe room");
 }
 
 Pipe::~Pipe()
 {
-    delete cond;
-    delete full;
-    delete empty;
+    delete lock;
+    delete dataAvail;
+    delete roomAvail;
 }
 
-char Pipe::GetChar()
+//----------------------------------------------------------------------
+// Pipe::Read
+// 	Wait until there is something to read, or no writer is left, and
+//	copy out up to "size" bytes -- all that are there, if they fit.
+//	Return the number copied; 0 means end of file.
+//----------------------------------------------------------------------
+
+int Pipe::Read(char *into, int size)
 {
-    while (pos == 0)
-        cond->Wait(empty);
+    if (size <= 0)
+        return 0;
+    lock->Acquire();
+    while (count == 0 && writers > 0)
+        dataAvail->Wait(lock);
 
-    char c = buffer[--pos];
-    cond->Signal(full);
-    return c;
+    int n = min(size, count);
+    int piece = min(n, PipeSize - head);
+    bcopy(&buffer[head], into, piece);
+    bcopy(buffer, into + piece, n - piece);
+    head = (head + n) % PipeSize;
+    count -= n;
+    if (n > 0)
+        roomAvail->Broadcast(lock);
+    lock->Release();
+    return n;
 }
 
-void Pipe::PutChar(char ch)
+//----------------------------------------------------------------------
+// Pipe::Write
+// 	Copy "size" bytes into the pipe, as much at a time as there is
+//	room for, waking the readers once per piece.  Wait for room while
+//	there are readers to make it; if they all close, stop there.
+//	Return the number of bytes written.
+//----------------------------------------------------------------------
+
+int Pipe::Write(char *from, int size)
 {
-    while (pos == BUFSIZE)
-        cond->Wait(full);
+    int done = 0;
+
+    lock->Acquire();
+    while (done < size)
+    {
+        while (count == PipeSize && readers > 0)
+            roomAvail->Wait(lock);
+        if (readers == 0) // no one will ever read it
+            break;
+
+        int n = min(size - done, PipeSize - count);
+        int tail = (head + count) % PipeSize;
+        int piece = min(n, PipeSize - tail);
+        bcopy(from + done, &buffer[tail], piece);
+        bcopy(from + done + piece, buffer, n - piece);
+        count += n;
+        done += n;
+        dataAvail->Broadcast(lock);
+    }
+    lock->Release();
+    return done;
+}
 
-    buffer[pos++] = ch;
-    cond->Signal(empty);
+//----------------------------------------------------------------------
+// Pipe::OpenEnd
+// 	Count another holder of the write end (if "writing") or the read
+//	end of the pipe.
+//----------------------------------------------------------------------
+
+void Pipe::OpenEnd(bool writing)
+{
+    lock->Acquire();
+    if (writing)
+        writers++;
+    else
+        readers++;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// Pipe::CloseEnd
+// 	Count one fewer holder of an end.  When the last writer goes,
+//	readers waiting for data get end of file; when the last reader
+//	goes, writers waiting for room give up.  Return TRUE if neither
+//	end is open any more, so the pipe can be deleted.
+//----------------------------------------------------------------------
+
+bool Pipe::CloseEnd(bool writing)
+{
+    lock->Acquire();
+    if (writing)
+    {
+        ASSERT(writers > 0);
+        if (--writers == 0)
+            dataAvail->Broadcast(lock);
+    }
+    else
+    {
+        ASSERT(readers > 0);
+        if (--readers == 0)
+            roomAvail->Broadcast(lock);
+    }
+    bool unused = (readers == 0 && writers == 0);
+    lock->Release();
+    return unused;
 }
@@ -1,6 +1,24 @@
-#include "synch.h"
-
-#define BUFSIZE 256
+// pipe.h
+//	Data structures for a pipe: a bounded FIFO of bytes between the
+//	threads holding its write end and the threads holding its read end.
+//
+//	Each pipe is an independent object, created by the MakePipe system
+//	call (or directly by kernel tests).  Data moves a whole span at a
+//	time: a writer copies as much as fits into the ring buffer before
+//	waking a reader, and a reader takes everything there is, so a busy
+//	pipe hands over kilobytes per context switch rather than a byte.
+//
+//	The ends are counted.  Once the last writer has closed, a reader
+//	gets what is left and then end of file (a read of 0 bytes); once
+//	the last reader has closed, a write returns short.  The pipe is
+//	deleted when both counts reach zero.
+
+#ifndef PIPE_H
+#define PIPE_H
+
+#include "copyright.h"
+
+#define PipeSize 4096 // bytes buffered between writers and readers
 
 class Condition;
 class Lock;
@@ -11,16 +29,25 @@ class Pipe
 	Pipe();
 	~Pipe();
 
-	void PutChar(char ch);
-	char GetChar();
+	int Read(char *into, int size);	 // Wait for data, then take up to
+									 // "size" bytes; 0 means end of file
+	int Write(char *from, int size); // Put all "size" bytes, waiting for
+									 // room; short if the readers are gone
 
-	int pos;  
+	void OpenEnd(bool writing);	 // Another holder of an end
+	bool CloseEnd(bool writing); // One fewer; TRUE if the pipe is now
+								 // unused, and the caller should delete it
 
   private:
-	char buffer[BUFSIZE];
-	Condition *cond; 
-	Lock *full;
-	Lock *empty;
+	char buffer[PipeSize]; // ring buffer of unread bytes
+	int head;			   // index of the oldest unread byte
+	int count;			   // number of unread bytes
+	int readers;		   // open read ends
+	int writers;		   // open write ends
+
+	Lock *lock;			  // protects all of the above
+	Condition *dataAvail; // a reader waits here for data or EOF
+	Condition *roomAvail; // a writer waits here for room
 };
 
-
+#endif // PIPE_H
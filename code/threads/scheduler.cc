@@ -11,8 +11,12 @@
 //	end up calling FindNextToRun(), and that would put us in an
 //	infinite loop.
 //
-// 	Very simple implementation -- no priorities, straight FIFO.
-//	Might need to be improved in later assignments.
+// 	Three policies, chosen with "-sched": straight FIFO, a multi-level
+//	feedback queue, or stride scheduling (see scheduler.h).  For the
+//	first two, each level has its own FIFO ready list, and a bit mask
+//	of the non-empty lists finds the highest level with a ready
+//	thread in O(1).  Stride scheduling keeps the ready threads in a
+//	heap ordered by pass.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -22,24 +26,59 @@
 #include "scheduler.h"
 #include "system.h"
 
+static char *policyNames[] = { "fifo", "mlfq", "stride" };
+
+// Passes wrap around; as long as they are within 2^31 of each other,
+// this still tells which is behind.
+#define PassBefore(a, b) ((int)((a) - (b)) < 0)
+
+// firstSet[mask] is the lowest bit set in "mask" -- the highest level
+// with a ready thread
+static char firstSet[1 << NumPriorities];
+
 //----------------------------------------------------------------------
 // Scheduler::Scheduler
-// 	Initialize the list of ready but not running threads to empty.
+// 	Initialize the lists of ready but not running threads to empty.
+//
+//	"how" is the scheduling policy
 //----------------------------------------------------------------------
 
-Scheduler::Scheduler()
+Scheduler::Scheduler(SchedPolicy how)
 {
-    readyList = new List;
+    int i, level;
+
+    policy = how;
+    for (i = 0; i < NumPriorities; i++)
+    {
+        readyList[i] = new List;
+        dispatches[i] = waitTicks[i] = 0;
+    }
+    readyMask = 0;
+    numReady = 0;
+    sliceStart = lastBoost = 0;
+    heapCapacity = 16;
+    strideHeap = new Thread *[heapCapacity];
+    heapSize = 0;
+    globalPass = 0;
+
+    for (i = 1; i < (1 << NumPriorities); i++)
+    {
+        for (level = 0; !(i & (1 << level)); level++)
+            ;
+        firstSet[i] = level;
+    }
 }
 
 //----------------------------------------------------------------------
 // Scheduler::~Scheduler
-// 	De-allocate the list of ready threads.
+// 	De-allocate the lists of ready threads.
 //----------------------------------------------------------------------
 
 Scheduler::~Scheduler()
 {
-    delete readyList;
+    for (int i = 0; i < NumPriorities; i++)
+        delete readyList[i];
+    delete[] strideHeap;
 }
 
 //----------------------------------------------------------------------
@@ -55,14 +94,37 @@ void Scheduler::ReadyToRun(Thread *thread)
     DEBUG('t', "Putting thread tid = %d \"%s\" on ready list.\n", thread->getTid(),
           thread->getName());
 
+    int level = (policy == SchedMlfq) ? thread->priority : 0;
+    bool yielding = (thread == currentThread && thread->getStatus() == RUNNING);
+
+    // bring the running thread's accounting up to date: if it is
+    // yielding, it is charged for its run; if not, the thread being
+    // woken starts from the running thread's current pass
+    if (currentThread->getStatus() == RUNNING)
+        Charge(currentThread);
     thread->setStatus(READY);
-    readyList->Append((void *)thread);
+    thread->readySince = stats->totalTicks;
+    numReady++;
+    if (policy == SchedStride)
+    {
+        // a thread that was blocked or new does not get to catch up
+        if (!yielding && PassBefore(thread->pass, globalPass))
+            thread->pass = globalPass;
+        HeapInsert(thread);
+    }
+    else
+    {
+        readyList[level]->Append((void *)thread);
+        readyMask |= (1 << level);
+    }
+    UpdateTimer();
 }
 
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
-// 	Return the next thread to be scheduled onto the CPU.
-//	If there are no ready threads, return NULL.
+// 	Return the next thread to be scheduled onto the CPU: the first
+//	one at the highest level that has any.  If there are no ready
+//	threads, return NULL.
 // Side effect:
 //	Thread is removed from the ready list.
 //----------------------------------------------------------------------
@@ -70,7 +132,213 @@ void Scheduler::ReadyToRun(Thread *thread)
 Thread *
 Scheduler::FindNextToRun()
 {
-    return (Thread *)readyList->Remove();
+    Thread *thread;
+    int level;
+
+    if (numReady == 0)
+    {
+        UpdateTimer();
+        return NULL;
+    }
+    if (policy == SchedStride)
+    {
+        thread = HeapRemoveMin();
+        globalPass = thread->pass;
+    }
+    else
+    {
+        if (policy == SchedMlfq && stats->totalTicks - lastBoost >= BoostInterval)
+            Boost();
+        level = firstSet[readyMask];
+        thread = (Thread *)readyList[level]->Remove();
+        if (readyList[level]->IsEmpty())
+            readyMask &= ~(1 << level);
+    }
+    numReady--;
+    UpdateTimer();
+    return thread;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::UpdateTimer
+// 	Stop the timer if no thread is waiting for the CPU, since there
+//	is nobody to switch to; otherwise make sure it is running.
+//----------------------------------------------------------------------
+
+void Scheduler::UpdateTimer()
+{
+    if (timer == NULL)
+        return;
+    if (numReady == 0)
+        timer->Stop();
+    else
+        timer->Start(Quantum(currentThread));
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Quantum
+// 	Return how long "thread" may run, from when it is dispatched,
+//	before the timer should go off.
+//----------------------------------------------------------------------
+
+int Scheduler::Quantum(Thread *thread)
+{
+    if (policy == SchedMlfq)
+    {
+        int left = TimeSlice(thread->priority) - thread->cpuUsed;
+        return (left > 0) ? left : 1;
+    }
+    return max(TimerTicks, TargetLatency / (numReady + 1));
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Boost
+// 	Move every thread back to level 0, with a fresh time slice, so
+//	that threads stuck at the bottom still get to run.
+//----------------------------------------------------------------------
+
+void Scheduler::Boost()
+{
+    DEBUG('t', "Boosting every thread to level 0\n");
+    for (int level = 1; level < NumPriorities; level++)
+        while (!readyList[level]->IsEmpty())
+        {
+            Thread *thread = (Thread *)readyList[level]->Remove();
+            thread->priority = 0;
+            thread->cpuUsed = 0;
+            readyList[0]->Append((void *)thread);
+        }
+    if (readyMask != 0)
+        readyMask = 1;
+    currentThread->priority = 0;
+    currentThread->cpuUsed = 0;
+    lastBoost = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Idle
+// 	Called when the running thread has gone to sleep and there is no
+//	other thread to run.  Charge it for what it ran up to now, then
+//	wait for an interrupt to make some thread ready.  The wait is
+//	nobody's CPU time, so the next Charge counts from when it ends.
+//----------------------------------------------------------------------
+
+void Scheduler::Idle()
+{
+    Charge(currentThread);
+    interrupt->Idle();
+    sliceStart = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::Charge
+// 	Account for the ticks "thread", the running thread, has run since
+//	it was dispatched or last charged: towards its MLFQ time slice,
+//	and under stride scheduling, by advancing its pass.  The pass of
+//	the thread run last is where a thread woken up starts from.
+//----------------------------------------------------------------------
+
+void Scheduler::Charge(Thread *thread)
+{
+    int used = stats->totalTicks - sliceStart;
+
+    sliceStart = stats->totalTicks;
+    thread->cpuUsed += used;
+    thread->ticksRun += used;
+    if (policy == SchedStride)
+    {
+        thread->pass += (unsigned int)(StrideOne / thread->tickets) * used;
+        globalPass = thread->pass;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::HeapInsert, Scheduler::HeapRemoveMin
+// 	Add a thread to the stride heap, or take off the one with the
+//	least pass, in O(log n).
+//----------------------------------------------------------------------
+
+void Scheduler::HeapInsert(Thread *thread)
+{
+    int pos;
+
+    if (heapSize == heapCapacity)
+    {
+        Thread **bigger = new Thread *[2 * heapCapacity];
+        for (pos = 0; pos < heapSize; pos++)
+            bigger[pos] = strideHeap[pos];
+        delete[] strideHeap;
+        strideHeap = bigger;
+        heapCapacity *= 2;
+    }
+    for (pos = heapSize++; pos > 0; pos = (pos - 1) / 2)
+    {
+        Thread *parent = strideHeap[(pos - 1) / 2];
+        if (!PassBefore(thread->pass, parent->pass))
+            break;
+        strideHeap[pos] = parent;
+    }
+    strideHeap[pos] = thread;
+}
+
+Thread *
+Scheduler::HeapRemoveMin()
+{
+    Thread *min = strideHeap[0];
+    Thread *last = strideHeap[--heapSize];
+    int pos = 0, child;
+
+    while ((child = 2 * pos + 1) < heapSize)
+    {
+        if (child + 1 < heapSize &&
+            PassBefore(strideHeap[child + 1]->pass, strideHeap[child]->pass))
+            child++;
+        if (!PassBefore(strideHeap[child]->pass, last->pass))
+            break;
+        strideHeap[pos] = strideHeap[child];
+        pos = child;
+    }
+    if (heapSize > 0)
+        strideHeap[pos] = last;
+    return min;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::SliceExpired
+// 	Called from the timer interrupt handler.  Return TRUE if the
+//	running thread should yield the CPU.
+//
+//	There is no point yielding if no other thread is ready.  Other
+//	than that, FIFO and stride scheduling yield on every timer
+//	interrupt.  MLFQ yields only once the thread has used up the time
+//	slice of its level, and then moves it down a level.
+//
+//	Either way, restart the timer if it is still needed.
+//----------------------------------------------------------------------
+
+bool Scheduler::SliceExpired()
+{
+    Thread *thread = currentThread;
+    bool expired;
+
+    Charge(thread);
+    if (numReady == 0)
+        expired = FALSE;
+    else if (policy != SchedMlfq)
+        expired = TRUE;
+    else if (thread->cpuUsed < TimeSlice(thread->priority))
+        expired = FALSE;
+    else
+    {
+        if (thread->priority < NumPriorities - 1)
+            thread->priority++;
+        thread->cpuUsed = 0;
+        DEBUG('t', "Thread tid = %d \"%s\" used up its slice, now at level %d\n",
+              thread->getTid(), thread->getName(), thread->priority);
+        expired = TRUE;
+    }
+    UpdateTimer();
+    return expired;
 }
 
 //----------------------------------------------------------------------
@@ -92,16 +360,26 @@ void Scheduler::Run(Thread *nextThread)
     Thread *oldThread = currentThread;
 
 #ifdef USER_PROGRAM // ignore until running user programs
-    if (currentThread->space != NULL)
-    {                                   // if this thread is a user program,
-        currentThread->SaveUserState(); // save the user's CPU registers
-        currentThread->space->SaveState();
-    }
+    if (currentThread->space != NULL)   // if this thread is a user program,
+        currentThread->SaveUserState(); // save the user's CPU registers;
+                                        // its address space stays loaded
+                                        // (see AddrSpace::RestoreState)
 #endif
 
     oldThread->CheckOverflow(); // check if the old thread
                                 // had an undetected stack overflow
 
+    Charge(oldThread);
+    stats->numContextSwitches++;
+    if (timer != NULL)
+    { // the next thread gets a whole time slice
+        timer->Stop();
+        if (numReady > 0)
+            timer->Start(Quantum(nextThread));
+    }
+    dispatches[nextThread->priority]++;
+    waitTicks[nextThread->priority] += stats->totalTicks - nextThread->readySince;
+
     currentThread = nextThread;        // switch to the next thread
     currentThread->setStatus(RUNNING); // nextThread is now running
 
@@ -136,7 +414,8 @@ void Scheduler::Run(Thread *nextThread)
     if (currentThread->space != NULL)
     {                                      // if there is an address space
         currentThread->RestoreUserState(); // to restore, do it.
-        currentThread->space->RestoreState();
+        currentThread->space->RestoreState(); // (nothing to do if it is
+                                              // still loaded)
     }
 #endif
 }
@@ -149,5 +428,47 @@ void Scheduler::Run(Thread *nextThread)
 void Scheduler::Print()
 {
     printf("Ready list contents:\n");
-    readyList->Mapcar((VoidFunctionPtr)ThreadPrint);
+    for (int level = 0; level < NumPriorities; level++)
+        readyList[level]->Mapcar((VoidFunctionPtr)ThreadPrint);
+    for (int i = 0; i < heapSize; i++)
+        ThreadPrint((int)strideHeap[i]);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::PrintStats
+// 	Print, for each level threads were run from, how many times they
+//	were, and how long on average they waited on the ready list.
+//----------------------------------------------------------------------
+
+void Scheduler::PrintStats()
+{
+    printf("Scheduler (%s):", policyNames[policy]);
+    for (int level = 0; level < NumPriorities; level++)
+        if (dispatches[level] > 0)
+            printf(" level %d: %d dispatches, average wait %d ticks;", level,
+                   dispatches[level], waitTicks[level] / dispatches[level]);
+    printf("\n");
+    if (policy != SchedStride)
+        return;
+
+    // share of the CPU each live thread was promised, and has had
+    int i, allTickets = 0, allRun = 0;
+    for (i = 0; i < numTids; i++)
+        if (tInfo[i].threadPointer != NULL)
+        {
+            allTickets += tInfo[i].threadPointer->tickets;
+            allRun += tInfo[i].threadPointer->ticksRun;
+        }
+    if (allRun == 0)
+        return;
+    printf("TID  NAME          TICKETS  SHARE  RAN\n");
+    for (i = 0; i < numTids; i++)
+    {
+        Thread *thread = tInfo[i].threadPointer;
+        if (thread != NULL)
+            printf("%-4d %-13s %7d %5d%% %3d%%\n", thread->getTid(),
+                   thread->getName(), thread->tickets,
+                   100 * thread->tickets / allTickets,
+                   (int)(100.0 * thread->ticksRun / allRun));
+    }
 }
@@ -12,6 +12,47 @@
 #include "copyright.h"
 #include "list.h"
 #include "thread.h"
+#include "stats.h"
+
+// How the next thread to run is chosen.
+enum SchedPolicy {
+    SchedFifo,			// one ready queue, first come first served;
+				// with -rs, yield at every timer interrupt
+    SchedMlfq,			// multi-level feedback queue
+    SchedStride			// proportional share, by stride scheduling
+};
+
+// Multi-level feedback queue parameters.  A thread starts at level 0,
+// the highest priority, and drops a level each time it uses up the
+// time slice of its level, however many times it gave up the CPU
+// along the way.  Lower levels get longer slices.  Every BoostInterval
+// ticks, every thread goes back to level 0, so none starves.
+
+#define NumPriorities	4		// levels; at most 8
+#define TimeSlice(level) (TimerTicks << (level))
+#define BoostInterval	(50 * TimerTicks)
+
+// The timer only runs while some thread is waiting for the CPU, and
+// each thread dispatched gets a fresh time slice.  Under MLFQ the slice
+// is whatever is left of its level's; otherwise TargetLatency is split
+// between the threads that want the CPU, down to at least TimerTicks,
+// so a few threads switch rarely and many still take turns quickly.
+
+#define TargetLatency	(8 * TimerTicks)
+
+// Stride scheduling parameters.  Each thread holds some tickets; the
+// ready thread with the least "pass" runs next, and its pass advances
+// by StrideOne / tickets for every tick it actually runs, so over time
+// each thread gets CPU in proportion to its tickets.  StrideOne is
+// large enough that the stride of MaxTickets is rounded by under 1%.
+// Passes wrap around, and are compared by their difference, which is
+// safe while the ready threads are within 2^31 of one another, i.e.
+// 2048 ticks of running at one ticket: woken threads start from the
+// pass of the thread run last, and no slice is nearly that long.
+
+#define DefaultTickets	100
+#define MaxTickets	10000
+#define StrideOne	(1 << 20)
 
 // The following class defines the scheduler/dispatcher abstraction -- 
 // the data structures and operations needed to keep track of which 
@@ -19,18 +60,55 @@
 
 class Scheduler {
   public:
-    Scheduler();			// Initialize list of ready threads 
+    Scheduler(SchedPolicy how = SchedFifo); // Initialize list of ready threads 
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
     void Run(Thread* nextThread);	// Cause nextThread to start running
+    void Idle();			// Nothing is ready: wait for an
+					// interrupt, without charging the
+					// sleeping thread for the wait
+    bool SliceExpired();		// Called on each timer interrupt:
+					// should the running thread yield?
+    void UpdateTimer();			// Run the timer if and only if some
+					// thread is waiting for the CPU
     void Print();			// Print contents of ready list
+    void PrintStats();			// Print how long threads waited to
+					// run, at each level, and under stride
+					// scheduling how their share of the
+					// CPU compares with their tickets
+
+    SchedPolicy getPolicy() { return policy; }
     
   private:
-    List *readyList;  		// queue of threads that are ready to run,
-				// but not running
+    SchedPolicy policy;
+    List *readyList[NumPriorities]; // queues of threads that are ready to
+				// run, but not running, one per level
+				// (FIFO only uses level 0)
+    int readyMask;		// bit i is set if readyList[i] is not empty
+    int numReady;		// threads on the ready lists or heap
+    int sliceStart;		// when the running thread was dispatched
+    int lastBoost;		// when every thread was last moved to level 0
+
+    void Boost();		// move every thread to level 0
+    int Quantum(Thread *thread); // how long "thread" may run, once
+				// dispatched, before the timer goes off
+    void Charge(Thread *thread); // account for the ticks "thread" has
+				// run since "sliceStart"
+
+    Thread **strideHeap;	// ready threads, least pass at the top
+    int heapSize;		// threads in "strideHeap"
+    int heapCapacity;		// room in "strideHeap"
+    unsigned int globalPass;	// pass of the thread run last, as of its
+				// last charge; a thread that was not
+				// ready starts from here
+    void HeapInsert(Thread *thread);
+    Thread *HeapRemoveMin();
+
+    int dispatches[NumPriorities]; // threads run from each level
+    int waitTicks[NumPriorities]; // total time they spent on the ready list
 };
 
 #endif // SCHEDULER_H
@@ -240,57 +240,160 @@ Barrier::Wait()
 	mutex->Release();
 }
 
-RWlock::RWlock()
+//----------------------------------------------------------------------
+// RWlock::RWlock
+// 	Initialize a read-write lock, free, ordering readers against
+//	writers as "how" says (see synch.h).
+//----------------------------------------------------------------------
+
+RWlock::RWlock(RWPolicy how)
 {
-	rCnt = 0;
-	rwlock = new Lock("read-write lock");
-	mutex = new Lock("mutex lock");
-	buflock = new Lock("buffer lock");
+	policy = how;
+	readers = 0;
+	writer = NULL;
+	waitingReaders = new List;
+	waitingWriters = new List;
+	numReads = numWrites = 0;
+	readWaits = writeWaits = 0;
+	peakReaders = 0;
 }
 
 RWlock::~RWlock()
 {
-	delete mutex;
-	delete rwlock;
-	delete buflock;
+	delete waitingReaders;
+	delete waitingWriters;
 }
 
+//----------------------------------------------------------------------
+// RWlock::ReadLock
+// 	Share the lock with the other readers.  Wait if a writer holds it,
+//	or -- unless readers are preferred -- if a writer is waiting for
+//	it, so that a stream of readers cannot starve the writers.  A
+//	waiting reader is admitted by whoever releases the lock, and
+//	returns holding it.
+//----------------------------------------------------------------------
+
 void
 RWlock::ReadLock()
 {
-	mutex->Acquire();
-	if (rCnt == 0)
-		rwlock->Acquire();
-	rCnt++;
-	mutex->Release();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-	buflock->Acquire();
+	numReads++;
+	if (writer != NULL ||
+		(policy != RWPreferReaders && !waitingWriters->IsEmpty()))
+	{
+		readWaits++;
+		waitingReaders->Append(currentThread);
+		currentThread->Sleep();		// AdmitReaders counted us
+	}
+	else
+	{
+		readers++;
+		peakReaders = max(peakReaders, readers);
+	}
+	(void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// RWlock::ReadUnlock
+// 	Stop reading.  The last reader out hands the lock to the first
+//	waiting writer.
+//----------------------------------------------------------------------
+
 void
 RWlock::ReadUnlock()
 {
-	buflock->Release();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-	mutex->Acquire();
-	rCnt--;
-	if (rCnt == 0)
-		rwlock->Release();
-	mutex->Release();
+	ASSERT(readers > 0 && writer == NULL);
+	if (--readers == 0)
+	{
+		if (!waitingWriters->IsEmpty())
+			AdmitWriter();
+		else
+			AdmitReaders();
+	}
+	(void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// RWlock::WriteLock
+// 	Take the lock alone, waiting (in FIFO order with the other
+//	writers) until no one else holds it.
+//----------------------------------------------------------------------
+
 void
 RWlock::WriteLock()
 {
-	while (rCnt > 0)
-		rwlock->Acquire();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-	buflock->Acquire();
+	numWrites++;
+	if (writer != NULL || readers > 0)
+	{
+		writeWaits++;
+		waitingWriters->Append(currentThread);
+		currentThread->Sleep();		// AdmitWriter made us the writer
+	}
+	else
+		writer = currentThread;
+	ASSERT(writer == currentThread);
+	(void) interrupt->SetLevel(oldLevel);
 }
+
+//----------------------------------------------------------------------
+// RWlock::WriteUnlock
+// 	Stop writing, and hand the lock on: to the whole batch of waiting
+//	readers, or to the next writer if there are none (or if writers
+//	are preferred).
+//----------------------------------------------------------------------
+
 void
 RWlock::WriteUnlock()
 {
-	buflock->Release();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
 
-	rwlock->Release();
-}
\ No newline at end of file
+	ASSERT(writer == currentThread);
+	writer = NULL;
+	if (policy == RWPreferWriters && !waitingWriters->IsEmpty())
+		AdmitWriter();
+	else if (!waitingReaders->IsEmpty())
+		AdmitReaders();
+	else if (!waitingWriters->IsEmpty())
+		AdmitWriter();
+	(void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// RWlock::AdmitReaders, RWlock::AdmitWriter
+// 	Give the free lock to every waiting reader, or to the first
+//	waiting writer, and wake them.  Called with interrupts off.
+//----------------------------------------------------------------------
+
+void
+RWlock::AdmitReaders()
+{
+	Thread *thread;
+
+	while ((thread = (Thread *)waitingReaders->Remove()) != NULL)
+	{
+		readers++;
+		scheduler->ReadyToRun(thread);
+	}
+	peakReaders = max(peakReaders, readers);
+}
+
+void
+RWlock::AdmitWriter()
+{
+	writer = (Thread *)waitingWriters->Remove();
+	scheduler->ReadyToRun(writer);
+}
+
+void
+RWlock::Print()
+{
+	printf("RWlock: %d readers, writer %s; reads %d (%d waited), "
+		   "writes %d (%d waited), peak readers %d\n", readers,
+		   (writer != NULL) ? writer->getName() : "none", numReads,
+		   readWaits, numWrites, writeWaits, peakReaders);
+}
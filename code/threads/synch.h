@@ -163,20 +163,57 @@ class Barrier {
 	Lock *mutex;
 };
 
+// The following class defines a "read-write lock".  Any number of
+// readers may hold it at once, or else a single writer:
+//
+//	ReadLock/ReadUnlock -- share the lock with other readers
+//
+//	WriteLock/WriteUnlock -- hold the lock alone
+//
+// Waiting threads queue in FIFO order, and a release hands the lock
+// straight to the threads it admits.  How readers and writers are
+// ordered against each other is set by the policy:
+//
+//	RWFair -- phase-fair: a reader arriving while a writer holds or
+//		waits for the lock waits for the next reader phase, and a
+//		writer's release admits every waiting reader at once as a
+//		batch.  Reader and writer phases alternate, so neither side
+//		can starve the other.
+//
+//	RWPreferReaders -- readers join whenever no writer holds the
+//		lock; writers wait for a moment with no readers.
+//
+//	RWPreferWriters -- a writer's release goes to the next waiting
+//		writer, if any, before the waiting readers.
+
+enum RWPolicy { RWFair, RWPreferReaders, RWPreferWriters };
+
 class RWlock {
   public:
-	RWlock();
+	RWlock(RWPolicy how = RWFair);	// initialize lock to be FREE
 	~RWlock();
 	void ReadLock();
 	void WriteLock();
 	void ReadUnlock();
 	void WriteUnlock();
-	void Print() { rwlock->Print(); }
+	void Print();
+
+	// contention counters
+	int numReads;		// read acquisitions
+	int numWrites;		// write acquisitions
+	int readWaits;		// read acquisitions that had to wait
+	int writeWaits;		// write acquisitions that had to wait
+	int peakReaders;	// most readers holding the lock at once
+
   private:
-	Lock *rwlock;
-	Lock *mutex;
-	Lock *buflock;
-	int rCnt;
+	void AdmitReaders();	// hand the lock to every waiting reader
+	void AdmitWriter();	// hand the lock to the first waiting writer
+
+	RWPolicy policy;
+	int readers;		// threads holding the lock to read
+	Thread *writer;		// thread holding it to write, or NULL
+	List *waitingReaders;	// FIFO queues of threads waiting for it
+	List *waitingWriters;
 };
 /* lab3 end */
 #endif // SYNCH_H
@@ -19,8 +19,11 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metrics
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+int stackCacheLimit = DefaultStackCache;	// most thread stacks kept
+						// for reuse
 /* lab1 begin */
-ThreadInfo tInfo[MAX_THREADS];
+ThreadInfo *tInfo = NULL;
+int numTids = 0;
 char tStatus[4][13] = { "JUST_CREATED", "RUNNING", "READY", "BLOCKED" };
 int UID = 1000;
 /* lab1 end */
@@ -28,12 +31,6 @@ int UID = 1000;
 int memCnt = 0;
 int missCnt = 0;
 /* lab4 end */
-/* lab5 begin */
-Pipe _pipe;
-/* lab5 begin */
-/* lab8 begin */ 
-int messageCnt[MAX_THREADS];
-/* lab8 end */
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
 #endif
@@ -44,6 +41,11 @@ SynchDisk   *synchDisk;
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
 Machine *machine;	// user program memory and registers
+Process *processTable[MAX_PROCESSES];	// indexed by pid
+BitMap *pidMap;		// which pids are in use
+AioManager *aioManager;
+SyscallTracer *syscallTracer;
+SynchConsole *synchConsole;
 #endif
 
 #ifdef NETWORK
@@ -58,7 +60,8 @@ extern void Cleanup();
 //----------------------------------------------------------------------
 // TimerInterruptHandler
 // 	Interrupt handler for the timer device.  The timer device is
-//	set up to interrupt the CPU periodically (once every TimerTicks).
+//	set up to interrupt the CPU at the end of each time slice, as long
+//	as some thread is waiting to run (see Scheduler::UpdateTimer).
 //	This routine is called each time there is a timer interrupt,
 //	with interrupts disabled.
 //
@@ -67,7 +70,8 @@ extern void Cleanup();
 //	which is what we wanted to context switch), we set a flag
 //	so that once the interrupt handler is done, it will appear as 
 //	if the interrupted thread called Yield at the point it is 
-//	was interrupted.
+//	was interrupted.  The scheduler decides whether the thread's
+//	time slice is up.
 //
 //	"dummy" is because every interrupt handler takes one argument,
 //		whether it needs it or not.
@@ -75,7 +79,7 @@ extern void Cleanup();
 static void
 TimerInterruptHandler(int dummy)
 {
-    if (interrupt->getStatus() != IdleMode)
+    if (interrupt->getStatus() != IdleMode && scheduler->SliceExpired())
 	interrupt->YieldOnReturn();
 }
 
@@ -95,12 +99,12 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    SchedPolicy policy = SchedFifo;
     
-    memset(tInfo, 0, sizeof(tInfo));
-    memset(messageCnt, 0, sizeof(messageCnt));
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
+    char *traceFileName = NULL;	// binary system call trace
 #endif
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
@@ -125,10 +129,28 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-sc")) {
+	    ASSERT(argc > 1);
+	    stackCacheLimit = atoi(*(argv + 1));
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-sched")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "mlfq"))
+		policy = SchedMlfq;
+	    else if (!strcmp(*(argv + 1), "stride"))
+		policy = SchedStride;
+	    else
+		ASSERT(!strcmp(*(argv + 1), "fifo"));
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
 	    debugUserProg = TRUE;
+	else if (!strcmp(*argv, "-st")) {
+	    ASSERT(argc > 1);
+	    traceFileName = *(argv + 1);
+	    argCount = 2;
+	}
 #endif
 #ifdef FILESYS_NEEDED
 	if (!strcmp(*argv, "-f"))
@@ -150,8 +172,8 @@ Initialize(int argc, char **argv)
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
     interrupt = new Interrupt;			// start up interrupt handling
-    scheduler = new Scheduler();		// initialize the ready queue
-    if (randomYield)				// start the timer (if needed)
+    scheduler = new Scheduler(policy);		// initialize the ready queue
+    if (randomYield || policy != SchedFifo)	// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
     threadToBeDestroyed = NULL;
@@ -162,18 +184,16 @@ Initialize(int argc, char **argv)
     currentThread = new Thread("main");		
     currentThread->setStatus(RUNNING);
 
-#ifdef USER_PROGRAM
-    for (int i = 0; i < MAX_THREADS; ++i)
-    {
-        currentThread->childThread[i] = NULL;
-    }
-    currentThread->fatherThread = NULL;
-#endif
     interrupt->Enable();
     CallOnUserAbort(Cleanup);			// if user hits ctl-C
     
 #ifdef USER_PROGRAM
     machine = new Machine(debugUserProg);	// this must come first
+    memset(processTable, 0, sizeof(processTable));
+    pidMap = new BitMap(MAX_PROCESSES);
+    aioManager = new AioManager;
+    syscallTracer = new SyscallTracer(traceFileName);
+    synchConsole = new SynchConsole(NULL, NULL);
 #endif
 
 #ifdef FILESYS
@@ -203,6 +223,10 @@ Cleanup()
     
 #ifdef USER_PROGRAM
     delete machine;
+    delete pidMap;
+    delete aioManager;
+    delete syscallTracer;
+    delete synchConsole;
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -224,7 +248,7 @@ void PrintThreadStates()
 {
     putchar('\n');
     printf("TID  UID  NAME          STATUS\n");
-    for (int i = 0; i < MAX_THREADS; ++i)
+    for (int i = 0; i < numTids; ++i)
     {
         if (tInfo[i].threadPointer != NULL)
         {
@@ -234,16 +258,3 @@ void PrintThreadStates()
     putchar('\n');
 }
 /* lab1 end */
-/* lab5 begin */
-void ReadPipe(char *into, int numBytes)
-{
-    for (int i = 0; i < numBytes; ++i)
-        into[i] = _pipe.GetChar();
-}
-
-void WritePipe(char *into, int numBytes)
-{
-    for (int i = 0; i < numBytes; ++i)
-        _pipe.PutChar(into[i]);
-}
-/* lab5 end */
@@ -17,8 +17,6 @@
 #include "timer.h"
 #include "pipe.h"
 
-#define MAX_THREADS 128
-
 // Initialization and cleanup routines
 extern void Initialize(int argc, char **argv); 	// Initialization,
 						// called before anything else
@@ -32,9 +30,12 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern int stackCacheLimit;			// most thread stacks kept
+						// for reuse
 
 /* lab1 begin */
-extern ThreadInfo tInfo[MAX_THREADS];
+extern ThreadInfo *tInfo;			// indexed by tid
+extern int numTids;				// entries in tInfo
 extern char tStatus[4][13];
 extern int UID;
 /* lab1 end */
@@ -42,18 +43,18 @@ extern int UID;
 extern int memCnt;
 extern int missCnt;
 /* lab4 end */
-/* lab5 begin */
-extern Pipe _pipe;
-extern void ReadPipe(char *into, int numBytes);
-extern void WritePipe(char *into, int numBytes);
-/* lab5 begin */
-/* lab8 begin */
-extern int messageCnt[MAX_THREADS];
-/* lab8 end */
 
 #ifdef USER_PROGRAM
 #include "machine.h"
+#include "process.h"
+#include "aio.h"
+#include "synchconsole.h"
 extern Machine* machine;	// user program memory and registers
+extern Process *processTable[MAX_PROCESSES];	// indexed by pid
+extern BitMap *pidMap;		// which pids are in use
+extern AioManager *aioManager;	// asynchronous I/O requests
+extern SyscallTracer *syscallTracer;	// times and logs system calls
+extern SynchConsole *synchConsole;	// console of user programs
 #endif
 
 #ifdef FILESYS_NEEDED 		// FILESYS or FILESYS_STUB 
@@ -9,6 +9,7 @@
 //	Sleep -- relinquish control over the CPU, but thread is now blocked.
 //		In other words, it will not run again, until explicitly
 //		put back on the ready queue.
+//	SleepFor -- Sleep, until a given amount of simulated time has passed
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation
@@ -29,59 +30,234 @@ int Thread::cntThreads = 0;
 /* lab1 end */
 
 /* lab8 begin */
-class Message
+#define NoMessage -1     // end of a chain of message slots
+#define SenderBuckets 8  // chains of messages, by sender tid
+
+struct Message
 {
-  public:
-    Message()
-    {
-        valid = false;
-        memset(buffer, 0, sizeof(buffer));
-        rwlock = new RWlock();
-    }
-    bool valid;
     int fromID;
+    int size;
+    int next; // next slot in the same chain
     char buffer[MAX_MESSAGE_SIZE];
-    RWlock *rwlock;
 };
-Message messageQueue[MAX_THREADS][MAX_MESSAGE_CNT];
+
+// The messages sent to a thread and not yet received.  There are
+// MAX_MESSAGE_CNT slots; each message waiting is on the chain of its
+// sender's bucket, oldest first, and the rest are on a free chain.
+// Since a message is always received by sender, it is found by
+// looking at one short chain, and taken off it without moving any
+// other message.  Only allocated once the thread needs it.
+class Mailbox
+{
+  public:
+    Mailbox(Thread *whose);
+
+    bool Put(int fromID, char *buffer, int size); // FALSE if full
+    int Take(int fromID, char *buffer, int size); // -1 if nothing from
+                                                  // "fromID"
+    void Wake();     // the owner has waited long enough
+
+    Thread *owner;   // the thread receiving
+    int waitingFor;  // the sender the owner is asleep waiting for, or -1
+    bool timedOut;   // the owner was woken by its timeout
+
+  private:
+    Message messages[MAX_MESSAGE_CNT];
+    int freeSlot;    // first free slot
+    int head[SenderBuckets], tail[SenderBuckets];
+};
+
+Mailbox::Mailbox(Thread *whose)
+{
+    owner = whose;
+    waitingFor = -1;
+    timedOut = FALSE;
+    for (int i = 0; i < MAX_MESSAGE_CNT; i++)
+        messages[i].next = i + 1;
+    messages[MAX_MESSAGE_CNT - 1].next = NoMessage;
+    freeSlot = 0;
+    for (int b = 0; b < SenderBuckets; b++)
+        head[b] = tail[b] = NoMessage;
+}
+
+bool Mailbox::Put(int fromID, char *buffer, int size)
+{
+    int b = (unsigned int)fromID % SenderBuckets;
+    int slot = freeSlot;
+
+    if (slot == NoMessage)
+        return FALSE;
+    freeSlot = messages[slot].next;
+    messages[slot].fromID = fromID;
+    messages[slot].size = size;
+    messages[slot].next = NoMessage;
+    memcpy(messages[slot].buffer, buffer, size);
+    if (tail[b] == NoMessage)
+        head[b] = slot;
+    else
+        messages[tail[b]].next = slot;
+    tail[b] = slot;
+    return TRUE;
+}
+
+int Mailbox::Take(int fromID, char *buffer, int size)
+{
+    int b = (unsigned int)fromID % SenderBuckets;
+    int prev = NoMessage, slot;
+
+    for (slot = head[b]; slot != NoMessage; prev = slot, slot = messages[slot].next)
+        if (messages[slot].fromID == fromID)
+            break;
+    if (slot == NoMessage)
+        return -1;
+
+    if (prev == NoMessage)
+        head[b] = messages[slot].next;
+    else
+        messages[prev].next = messages[slot].next;
+    if (tail[b] == slot)
+        tail[b] = prev;
+    size = min(size, messages[slot].size);
+    memcpy(buffer, messages[slot].buffer, size);
+    messages[slot].next = freeSlot;
+    freeSlot = slot;
+    return size;
+}
+
+void Mailbox::Wake()
+{
+    if (waitingFor == -1)
+        return;
+    waitingFor = -1;
+    scheduler->ReadyToRun(owner);
+}
+
+// ReceiveM's timeout, an alarm interrupt
+static void MailboxTimeout(int arg)
+{
+    Mailbox *box = (Mailbox *)arg;
+
+    if (box->waitingFor != -1)
+        box->timedOut = TRUE;
+    box->Wake();
+}
 /* lab8 end */
+
+#define InitialTids 16 // size of the thread table, to begin with
+
+static int *freeStacks = NULL; // stacks of StackSize words kept for
+                               // reuse, chained through their first word
+static int numFreeStacks = 0;
+
+//----------------------------------------------------------------------
+// GetStack, PutStack
+// 	Allocate a guarded execution stack of "size" words, or give one
+//	back.  Stacks of the standard size come from, and go back to, a
+//	free list of up to stackCacheLimit stacks, so that forking many
+//	short-lived threads does not map and unmap a stack each time.
+//----------------------------------------------------------------------
+
+static int *GetStack(int size)
+{
+    int *stack;
+
+    if (size != StackSize || freeStacks == NULL)
+        return (int *)AllocBoundedArray(size * sizeof(int));
+    stack = freeStacks;
+    freeStacks = *(int **)stack;
+    numFreeStacks--;
+    return stack;
+}
+
+static void PutStack(int *stack, int size)
+{
+    if (size != StackSize || numFreeStacks >= stackCacheLimit)
+    {
+        DeallocBoundedArray((char *)stack, size * sizeof(int));
+        return;
+    }
+    *(int **)stack = freeStacks;
+    freeStacks = stack;
+    numFreeStacks++;
+}
+
+static int freeTid = -1; // first free entry in tInfo, -1 if none
+
+//----------------------------------------------------------------------
+// AllocTid, FreeTid
+// 	Hand out a tid, with its entry in the thread table, or give one
+//	back, in O(1).  Free tids are kept on a list, and the table
+//	doubles in size when there are none left.
+//----------------------------------------------------------------------
+
+static int AllocTid(Thread *thread, char *threadName)
+{
+    int tid;
+
+    if (freeTid == -1)
+    {
+        int newSize = (numTids == 0) ? InitialTids : 2 * numTids;
+        ThreadInfo *newInfo = new ThreadInfo[newSize];
+        for (tid = 0; tid < numTids; tid++)
+            newInfo[tid] = tInfo[tid];
+        for (tid = newSize - 1; tid >= numTids; tid--)
+        {
+            newInfo[tid].threadPointer = NULL;
+            newInfo[tid].nextFree = freeTid;
+            freeTid = tid;
+        }
+        delete[] tInfo;
+        tInfo = newInfo;
+        numTids = newSize;
+    }
+    tid = freeTid;
+    freeTid = tInfo[tid].nextFree;
+    tInfo[tid].threadPointer = thread;
+    tInfo[tid].uid = UID;
+    tInfo[tid].name = threadName;
+    tInfo[tid].status = tStatus[JUST_CREATED];
+    return tid;
+}
+
+static void FreeTid(int tid)
+{
+    tInfo[tid].threadPointer = NULL;
+    tInfo[tid].nextFree = freeTid;
+    freeTid = tid;
+}
 //----------------------------------------------------------------------
 // Thread::Thread
 // 	Initialize a thread control block, so that we can then call
 //	Thread::Fork.
 //
 //	"threadName" is an arbitrary string, useful for debugging.
+//	"stackWords" is the size of its stack, in words; threads that
+//		recurse deeply may need more than the standard StackSize.
 //----------------------------------------------------------------------
 
-Thread::Thread(char *threadName)
+Thread::Thread(char *threadName, int stackWords)
 {
     /* lab1 begin */
     cntThreads++;
-    ASSERT(cntThreads <= MAX_THREADS);
-    int cnt = 0;
-    for (; cnt < MAX_THREADS; cnt++)
-    {
-        if (tInfo[cnt].threadPointer == NULL)
-        {
-            tInfo[cnt].threadPointer = this;
-            tInfo[cnt].uid = UID;
-            tInfo[cnt].name = threadName;
-            tInfo[cnt].status = tStatus[JUST_CREATED];
-            break;
-        }
-    }
     name = threadName;
-    tid = cnt;
+    tid = AllocTid(this, threadName);
     uid = UID;
     /* lab1 end */
+    mailbox = NULL;
     stackTop = NULL;
     stack = NULL;
+    stackSize = stackWords;
     status = JUST_CREATED;
+    priority = 0;
+    cpuUsed = 0;
+    readySince = 0;
+    tickets = DefaultTickets;
+    pass = 0;
+    ticksRun = 0;
 #ifdef USER_PROGRAM
-    for (int i = 0; i < MAX_THREADS; ++i)
-        childThread[i] = NULL;
-    fatherThread = NULL;
+    process = NULL;
     space = NULL;
+    userStack = 0;
 #endif
 }
 
@@ -105,10 +281,11 @@ Thread::~Thread()
     /* lab1 end */
     ASSERT(this != currentThread);
     /* lab1 begin */
-    tInfo[tid].threadPointer = NULL;
+    FreeTid(tid);
     /* lab1 end */
+    delete mailbox;
     if (stack != NULL)
-        DeallocBoundedArray((char *)stack, StackSize * sizeof(int));
+        PutStack(stack, stackSize);
 }
 
 //----------------------------------------------------------------------
@@ -163,7 +340,7 @@ void Thread::CheckOverflow()
 {
     if (stack != NULL)
 #ifdef HOST_SNAKE // Stacks grow upward on the Snakes
-        ASSERT(stack[StackSize - 1] == STACK_FENCEPOST);
+        ASSERT(stack[stackSize - 1] == STACK_FENCEPOST);
 #else
         ASSERT((int)*stack == (int)STACK_FENCEPOST);
 #endif
@@ -180,6 +357,9 @@ void Thread::CheckOverflow()
 //	so that Scheduler::Run() will call the destructor, once we're
 //	running in the context of a different thread.
 //
+//	A user thread also leaves its process; if it was the last thread
+//	there, the process exits (see Process::RemoveThread).
+//
 // 	NOTE: we disable interrupts, so that we don't get a time slice
 //	between setting threadToBeDestroyed, and going to sleep.
 //----------------------------------------------------------------------
@@ -187,22 +367,17 @@ void Thread::CheckOverflow()
 //
 void Thread::Finish()
 {
-    (void)interrupt->SetLevel(IntOff);
     ASSERT(this == currentThread);
-
-    DEBUG('t', "Finishing thread tid = %d \"%s\"\n", getTid(), getName());
 #ifdef USER_PROGRAM
-    while (!NoChild())
-    {
-        currentThread->Yield();
-    }
-    if (fatherThread != NULL)
+    if (process != NULL)
     {
-        int id = fatherThread->FindChildID(this);
-        ASSERT(id != -1);
-        fatherThread->childThread[id] = NULL;
+        process->RemoveThread();
+        process = NULL;
     }
 #endif
+    (void)interrupt->SetLevel(IntOff);
+
+    DEBUG('t', "Finishing thread tid = %d \"%s\"\n", getTid(), getName());
     threadToBeDestroyed = currentThread;
     Sleep(); // invokes SWITCH
     // not reached
@@ -214,9 +389,12 @@ void Thread::Finish()
 //	If so, put the thread on the end of the ready list, so that
 //	it will eventually be re-scheduled.
 //
-//	NOTE: returns immediately if no other thread on the ready queue.
-//	Otherwise returns when the thread eventually works its way
-//	to the front of the ready list and gets re-scheduled.
+//	NOTE: returns immediately if no other thread on the ready queue
+//	should run before us.  Otherwise returns when the thread eventually
+//	works its way to the front of the ready list and gets re-scheduled.
+//	The thread goes back on the ready list *before* the scheduler
+//	picks, so that with priorities we do not hand the CPU to a thread
+//	that should run after us.
 //
 //	NOTE: we disable interrupts, so that looking at the thread
 //	on the front of the ready list, and switching to it, can be done
@@ -235,12 +413,12 @@ void Thread::Yield()
 
     DEBUG('t', "Yielding thread tid = %d \"%s\"\n", getTid(), getName());
 
+    scheduler->ReadyToRun(this);
     nextThread = scheduler->FindNextToRun();
-    if (nextThread != NULL)
-    {
-        scheduler->ReadyToRun(this);
+    if (nextThread != this)
         scheduler->Run(nextThread);
-    }
+    else
+        setStatus(RUNNING); // no one else to run
     (void)interrupt->SetLevel(oldLevel);
 }
 
@@ -274,11 +452,39 @@ void Thread::Sleep()
 
     status = BLOCKED;
     while ((nextThread = scheduler->FindNextToRun()) == NULL)
-        interrupt->Idle(); // no one to run, wait for an interrupt
+        scheduler->Idle(); // no one to run, wait for an interrupt
 
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// Thread::SleepFor
+// 	Block the current thread until at least "ticks" of simulated time
+//	have passed.  The wakeup is an alarm interrupt in the pending
+//	interrupt queue, which is already sorted by time, so the thread is
+//	not on the ready list meanwhile.  If nothing else is runnable, the
+//	machine idles, moving the clock straight to the next interrupt.
+//
+//	"ticks" is how long to sleep; if it is not positive, return at once
+//----------------------------------------------------------------------
+
+static void ThreadWakeUp(int arg) { scheduler->ReadyToRun((Thread *)arg); }
+
+void Thread::SleepFor(int ticks)
+{
+    ASSERT(this == currentThread);
+    if (ticks <= 0)
+        return;
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    DEBUG('t', "Thread tid = %d \"%s\" sleeping for %d ticks\n", getTid(),
+          getName(), ticks);
+    interrupt->Schedule(ThreadWakeUp, (int)this, ticks, AlarmInt);
+    Sleep();
+    (void)interrupt->SetLevel(oldLevel);
+}
+
 void Thread::setStatus(ThreadStatus st)
 {
     tInfo[tid].status = tStatus[st];
@@ -315,19 +521,19 @@ void ThreadPrint(int arg)
 
 void Thread::StackAllocate(VoidFunctionPtr func, void *arg)
 {
-    stack = (int *)AllocBoundedArray(StackSize * sizeof(int));
+    stack = GetStack(stackSize);
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
     stackTop = stack + 16; // HP requires 64-byte frame marker
-    stack[StackSize - 1] = STACK_FENCEPOST;
+    stack[stackSize - 1] = STACK_FENCEPOST;
 #else
 // i386 & MIPS & SPARC stack works from high addresses to low addresses
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
-    stackTop = stack + StackSize - 96;
+    stackTop = stack + stackSize - 96;
 #else // HOST_MIPS  || HOST_i386
-    stackTop = stack + StackSize - 4; // -4 to be on the safe side!
+    stackTop = stack + stackSize - 4; // -4 to be on the safe side!
 #ifdef HOST_i386
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
@@ -346,64 +552,86 @@ void Thread::StackAllocate(VoidFunctionPtr func, void *arg)
     machineState[WhenDonePCState] = (int *)ThreadFinish;
 }
 
+//----------------------------------------------------------------------
+// Thread::SendM
+// 	Leave a message of "size" bytes from "buffer" in the mailbox of
+//	thread "tid", and wake it up if it is waiting for one from us.
+//	Return 0, or -1 if there is no such thread, the message is too
+//	long, or the mailbox is full.
+//----------------------------------------------------------------------
+
 int Thread::SendM(int tid, char *buffer, int size)
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
     int curr_tid = currentThread->getTid();
+    Thread *receiver = (tid >= 0 && tid < numTids) ? tInfo[tid].threadPointer : NULL;
+    if (receiver == NULL)
+    {
+        printf("No thread %d to send to!\n", tid);
+        (void)interrupt->SetLevel(oldLevel);
+        return -1;
+    }
     if (size > MAX_MESSAGE_SIZE)
     {
         printf("Message too large to send!\n");
         (void)interrupt->SetLevel(oldLevel);
         return -1;
     }
-    int cnt = messageCnt[tid];
-    messageQueue[tid][cnt].rwlock->WriteLock();
-    if (cnt >= MAX_MESSAGE_CNT)
+    if (receiver->mailbox == NULL)
+        receiver->mailbox = new Mailbox(receiver);
+    if (!receiver->mailbox->Put(curr_tid, buffer, size))
     {
         printf("Too much message!\n");
-        messageQueue[tid][cnt].rwlock->WriteUnlock();
         (void)interrupt->SetLevel(oldLevel);
         return -1;
     }
-    messageCnt[tid]++;
-    messageQueue[tid][cnt].valid = true;
-    messageQueue[tid][cnt].fromID = curr_tid;
-    memcpy(messageQueue[tid][cnt].buffer, buffer, size);
-    messageQueue[tid][cnt].rwlock->WriteUnlock();
+    if (receiver->mailbox->waitingFor == curr_tid)
+        receiver->mailbox->Wake();
     printf("Send from Thread %d to %d complete\n", curr_tid, tid);
     (void)interrupt->SetLevel(oldLevel);
     return 0;
 }
 
-void Thread::ReceiveM(int tid, char *buffer, int size)
+//----------------------------------------------------------------------
+// Thread::ReceiveM
+// 	Take the oldest message from thread "tid" out of our mailbox, and
+//	copy up to "size" bytes of it to "buffer".  If there is none, go
+//	to sleep until the sender wakes us up -- or, if "timeout" is
+//	positive, until that many ticks have passed.
+//
+//	Return how many bytes were copied, or -1 if there was no message
+//	(only if "timeout" is not negative).
+//----------------------------------------------------------------------
+
+int Thread::ReceiveM(int tid, char *buffer, int size, int timeout)
 {
     IntStatus oldLevel = interrupt->SetLevel(IntOff);
-    int curr_tid = currentThread->getTid();
-    int found_id;
-    while (messageCnt[curr_tid] == 0)
-    {
-        currentThread->Yield();
-    }
+    int curr_tid = getTid();
+    int got, alarm = 0;
 
-    for (int i = MAX_MESSAGE_CNT - 1; i >= 0; --i)
+    ASSERT(this == currentThread);
+    if (mailbox == NULL)
+        mailbox = new Mailbox(this);
+    mailbox->timedOut = FALSE;
+    while ((got = mailbox->Take(tid, buffer, size)) == -1)
     {
-        if (messageQueue[curr_tid][i].valid && messageQueue[curr_tid][i].fromID == tid)
-        {
-            messageQueue[curr_tid][i].rwlock->ReadLock();
-            messageQueue[curr_tid][i].valid = false;
-            memcpy(buffer, messageQueue[curr_tid][i].buffer, size);
-            messageCnt[curr_tid]--;
-            messageQueue[curr_tid][i].rwlock->ReadUnlock();
-            found_id = i;
+        if (timeout == 0 || mailbox->timedOut)
             break;
-        }
-    }
-    for (int i = found_id; i < MAX_MESSAGE_CNT - 1; ++i)
-    {
-        messageQueue[curr_tid][i] = messageQueue[curr_tid][i + 1];
+        if (timeout > 0 && alarm == 0)
+            alarm = interrupt->Schedule(MailboxTimeout, (int)mailbox, timeout,
+                                        AlarmInt);
+        mailbox->waitingFor = tid;
+        Sleep();
     }
-    printf("Receive from Thread %d to %d complete\n", tid, curr_tid);
+    if (alarm != 0)
+        (void)interrupt->Cancel(alarm);
+
+    if (got == -1)
+        printf("Receive from Thread %d to %d: no message\n", tid, curr_tid);
+    else
+        printf("Receive from Thread %d to %d complete\n", tid, curr_tid);
     (void)interrupt->SetLevel(oldLevel);
+    return got;
 }
 
 #ifdef USER_PROGRAM
@@ -430,33 +658,16 @@ void Thread::SaveUserState()
 //
 //	Note that a user program thread has *two* sets of CPU registers --
 //	one for its state while executing user code, one for its state
-//	while executing kernel code.  This routine restores the former.
+//	while executing kernel code.  This routine restores the former,
+//	and tells the kernel info page who is running.
 //----------------------------------------------------------------------
 
 void Thread::RestoreUserState()
 {
     for (int i = 0; i < NumTotalRegs; i++)
         machine->WriteRegister(i, userRegisters[i]);
-}
-
-int Thread::FindChildID(Thread *t)
-{
-    for (int i = 0; i < MAX_THREADS; ++i)
-    {
-        if (childThread[i] == t)
-            return i;
-    }
-    return -1;
-}
-
-bool Thread::NoChild()
-{
-    for (int i = 0; i < MAX_THREADS; ++i)
-    {
-        if (childThread[i] != NULL)
-            return false;
-    }
-    return true;
+    machine->WriteInfo(InfoPid, (process != NULL) ? process->getPid() : -1);
+    machine->WriteInfo(InfoTid, tid);
 }
 
 #endif
@@ -42,14 +42,16 @@
 #include "synch.h"
 
 
-#define MAX_THREADS 128
 #define MAX_MESSAGE_SIZE 128
 #define MAX_MESSAGE_CNT 128
 
+class Mailbox;
+
 #ifdef USER_PROGRAM
 #include "machine.h"
 #include "addrspace.h"
 
+class Process;
 #endif
 
 // CPU register state to be saved on context switch.
@@ -59,8 +61,14 @@
 
 // Size of the thread's private execution stack.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
+// A thread that needs more (or less) can ask for it when it is created.
 #define StackSize (4 * 1024) // in words
 
+// Stacks of the standard size are not given back to the host when a
+// thread is deleted, but kept for the next thread, up to
+// stackCacheLimit of them (see system.cc).
+#define DefaultStackCache 16
+
 // Thread state
 enum ThreadStatus
 {
@@ -93,7 +101,9 @@ class Thread
 	void *machineState[MachineStateSize]; // all registers except for stackTop
 
   public:
-	Thread(char *debugName); // initialize a Thread
+	Thread(char *debugName, int stackWords = StackSize);
+							 // initialize a Thread, with a
+							 // stack of "stackWords" words
 	~Thread();				 // deallocate a Thread
 	// NOTE -- thread being deleted
 	// must not be running when delete
@@ -106,29 +116,45 @@ class Thread
 												// other thread is runnable
 	void Sleep();								// Put the thread to sleep and
 												// relinquish the processor
+	void SleepFor(int ticks);					// Sleep until "ticks" of
+												// simulated time have passed
 	void Finish();								// The thread is done executing
 
 	void CheckOverflow(); // Check if thread has
 						  // overflowed its stack
 	void setStatus(ThreadStatus st);
+	ThreadStatus getStatus() { return status; }
 	char *getName() { return (name); }
 	void Print() { printf("%s, ", name); }
 	/* lab8 begin */
 	int SendM(int tid, char *buffer, int size);
-	void ReceiveM(int tid, char *buffer, int size);
+	int ReceiveM(int tid, char *buffer, int size, int timeout = -1);
+	// Receive the oldest message from thread "tid": wait for one if
+	// "timeout" < 0, don't wait if it is 0, and otherwise wait at
+	// most "timeout" ticks.  Return the message size, or -1 if none
 	/* lab8 end *
 	/* lab1 begin */
-	static int cntThreads;
+	static int cntThreads; // threads in existence
 	int getUid() { return (uid); }
 	int getTid() { return (tid); }
 	/* lab1 end */
 
+	// scheduling state, kept by the Scheduler
+	int priority;	// MLFQ level, 0 the highest
+	int cpuUsed;	// ticks run at this level so far
+	int readySince; // when it was last put on the ready list
+	int tickets;	// share of the CPU, under stride scheduling
+	unsigned int pass; // stride scheduling virtual time: advances by
+					   // StrideOne / tickets per tick run
+	int ticksRun;	// ticks run since the thread was created
+
   private:
 	// some of the private data for this class is listed above
 
 	int *stack; // Bottom of the stack
 	// NULL if this is the main thread
 	// (If NULL, don't deallocate stack)
+	int stackSize; // in words
 	ThreadStatus status; // ready, running or blocked
 	char *name;
 
@@ -140,6 +166,8 @@ class Thread
 	int tid;
 	int uid;
 /* lab1 end */
+	Mailbox *mailbox; // messages sent to us; NULL until the first
+					  // one arrives
 #ifdef USER_PROGRAM
 	// A thread running a user program actually has *two* sets of CPU registers --
 	// one for its state while executing user code, one for its state
@@ -150,22 +178,26 @@ class Thread
   public:
 	void SaveUserState();	// save user-level register state
 	void RestoreUserState(); // restore user-level register state
-	bool NoChild();
-	int FindChildID(Thread *t);
-	Thread *childThread[MAX_THREADS];
-	Thread *fatherThread;
 
+	Process *process; // Process this thread belongs to, NULL for
+					  // kernel-only threads
 	AddrSpace *space; // User code this thread is running.
+	int userStack;	  // Initial stack pointer of a Fork'ed thread,
+					  // 0 for the stack the program started on
 #endif
 };
 
 /* lab1 begin */
+// The thread table, tInfo, has an entry for every tid handed out so
+// far, and grows as needed.  Entries of tids not in use are chained
+// together through "nextFree".
 struct ThreadInfo
 {
-	Thread *threadPointer;
+	Thread *threadPointer; // NULL if the tid is free
 	int uid;
 	char *name;
 	char *status;
+	int nextFree;
 };
 /* lab1 end */
 
@@ -224,23 +224,36 @@ barrier_test()
 }
 
 RWlock *rw = new RWlock;
+int rwReading, rwWriting, rwErrors, rwDone;
 
+// Readers and writers Yield while they hold the lock, so that the
+// others try to get in: readers should overlap, writers never should.
 void readBuffer(int num)
 {
 	char readContent[50];
 	rw->ReadLock();
+	rwReading++;
+	if (rwWriting > 0)
+		rwErrors++;
 	sscanf(buffer, "%[^\n]", readContent);
 	printf("reader %d read \"%s\"\n", num, readContent);
-	rw->Print();
+	currentThread->Yield();
+	rwReading--;
 	rw->ReadUnlock();
+	rwDone++;
 }
 void writeBuffer(int num)
 {
 	rw->WriteLock();
+	if (rwReading > 0 || rwWriting > 0)
+		rwErrors++;
+	rwWriting++;
 	sprintf(buffer, "Hello from writer %d.", num);
 	printf("writer %d modify\n", num);
-	rw->Print();
+	currentThread->Yield();
+	rwWriting--;
 	rw->WriteUnlock();
+	rwDone++;
 }
 
 void rwlockTest()
@@ -257,7 +270,12 @@ void rwlockTest()
 			tw[i >> 1]->Fork(writeBuffer, (void*)(i >> 1));
 		}
 	}
-	currentThread->Yield();
+	while (rwDone < 7)
+		currentThread->Yield();
+	rw->Print();
+	if (rw->peakReaders < 2)	// readers never shared the lock
+		rwErrors++;
+	printf("rwlock test: %d errors\n", rwErrors);
 }
 /* lab3 end */
 
@@ -292,9 +310,121 @@ void messageTest()
 		recvr[i - 1]->Fork(receivem, (void*)i);
 	}
 	currentThread->Yield();
+
+	// nobody sends to us: don't wait, then wait a while
+	char message[30];
+	int start = stats->totalTicks;
+	if (currentThread->ReceiveM(1, message, 30, 0) != -1 ||
+		currentThread->ReceiveM(1, message, 30, 500) != -1 ||
+		stats->totalTicks - start < 500)
+		printf("Receive timeouts broken\n");
 }
 /* lab8 end */
 
+//----------------------------------------------------------------------
+// mlfqTest
+// 	Two CPU hogs and a thread that only runs in short bursts.  Run
+//	with "-sched mlfq": the hogs sink to the bottom level, while the
+//	short thread, which uses far less CPU, stays above them.
+//----------------------------------------------------------------------
+
+void
+Spin(int ticks)
+{
+	for (int i = 0; i < ticks; i += SystemTick)
+	{
+		interrupt->SetLevel(IntOff);	// re-enabling interrupts
+		interrupt->SetLevel(IntOn);	// advances the clock
+	}
+}
+
+void
+hog(int which)
+{
+	Spin(30 * TimerTicks);
+	printf("hog %d done at level %d\n", which, currentThread->priority);
+}
+
+void
+burst(int which)
+{
+	for (int i = 0; i < 20; i++)
+	{
+		Spin(TimerTicks / 4);
+		currentThread->Yield();
+	}
+	printf("burst %d done at level %d\n", which, currentThread->priority);
+}
+
+void
+mlfqTest()
+{
+	Thread *t;
+
+	for (int i = 0; i < 2; i++)
+	{
+		t = new Thread("hog");
+		t->Fork(hog, (void*)i);
+	}
+	t = new Thread("burst");
+	t->Fork(burst, (void*)0);
+	currentThread->Yield();
+}
+
+//----------------------------------------------------------------------
+// manyThreadsTest
+// 	Create far more threads than the thread table starts out with,
+//	in waves, so that tids (and stacks) are reused as well as added.
+//	Then recurse far deeper than a standard stack allows, in a thread
+//	created with a bigger one.
+//----------------------------------------------------------------------
+
+int threadsDone;
+
+void
+countDone(int which)
+{
+	threadsDone++;
+}
+
+int
+recurse(int depth)
+{
+	int frame[64];
+
+	frame[depth % 64] = depth;
+	if (depth == 0)
+		return 0;
+	return recurse(depth - 1) + frame[depth % 64] - depth + 1;
+}
+
+void
+deep(int depth)
+{
+	printf("recursed %d deep\n", recurse(depth));
+	threadsDone++;
+}
+
+void
+manyThreadsTest()
+{
+	for (int wave = 0; wave < 4; wave++)
+	{
+		for (int i = 0; i < 500; i++)
+		{
+			Thread *t = new Thread("many");
+			t->Fork(countDone, (void*)i);
+		}
+		while (threadsDone < 500 * (wave + 1))
+			currentThread->Yield();
+	}
+	Thread *t = new Thread("deep", 64 * StackSize);
+	t->Fork(deep, (void*)2000);
+	while (threadsDone < 2001)
+		currentThread->Yield();
+	printf("%d threads done, thread table has %d entries\n", threadsDone, numTids);
+}
+
 //----------------------------------------------------------------------
 // ThreadTest
 // 	Invoke a test routine.
@@ -340,6 +470,16 @@ ThreadTest()
 		messageTest();
 		break;
 	}
+	case 8:
+	{
+		mlfqTest();
+		break;
+	}
+	case 9:
+	{
+		manyThreadsTest();
+		break;
+	}
 	default:
 	printf("No test specified.\n");
 	break;
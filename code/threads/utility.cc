@@ -62,7 +62,7 @@ DebugIsEnabled(char flag)
 //----------------------------------------------------------------------
 
 void 
-DEBUG(char flag, char *format, ...)
+DEBUG(char flag, const char *format, ...)
 {
     if (DebugIsEnabled(flag)) {
 	va_list ap;
@@ -14,6 +14,7 @@
 //   	'd' -- disk emulation (FILESYS)
 //   	'f' -- file system (FILESYS)
 //   	'a' -- address spaces (USER_PROGRAM)
+//   	'y' -- system calls (USER_PROGRAM)
 //   	'n' -- network emulation (NETWORK)
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -62,7 +63,7 @@ extern void DebugInit(char* flags);	// enable printing debug messages
 
 extern bool DebugIsEnabled(char flag); 	// Is this debug flag enabled?
 
-extern void DEBUG (char flag, char* format, ...);  	// Print debug message 
+extern void DEBUG (char flag, const char* format, ...);  	// Print debug message 
 							// if flag is enabled
 
 //----------------------------------------------------------------------
@@ -23,6 +23,11 @@
 #include <strings.h>
 #endif
 
+// The address space whose pages are in physical memory, and whose page
+// table is installed -- left there while kernel-only threads run, and
+// only saved when a different address space needs the machine.
+static AddrSpace *loadedSpace = NULL;
+
 //----------------------------------------------------------------------
 // SwapHeader
 // 	Do little endian to big endian conversion on the bytes in the
@@ -57,24 +62,40 @@ SwapHeader(NoffHeader *noffH)
 //	memory.  For now, this is really simple (1:1), since we are
 //	only uniprogramming, and we have a single unsegmented page table
 //
-//	"executable" is the file containing the object code to load into memory
+//	"executable" is the file containing the object code to load into
+//	memory -- or a checkpoint written by Checkpoint, in which case the
+//	process carries on where it was, and its pages are read from
+//	"executable" lazily, as they are touched.  Either way the address
+//	space keeps "executable", and deletes it when it goes away.
 //----------------------------------------------------------------------
 
 AddrSpace::AddrSpace(OpenFile *executable)
 {
     NoffHeader noffH;
     unsigned int i, size;
+    bool restoring;
+
+    image = executable;
+    imageOffset = NULL;
+    imagePages = 0;
+    savedRegisters = NULL;
 
     executable->ReadAt((char *)&noffH, sizeof(noffH), 0);
-    if ((noffH.noffMagic != NOFFMAGIC) &&
-        (WordToHost(noffH.noffMagic) == NOFFMAGIC))
-        SwapHeader(&noffH);
-    ASSERT(noffH.noffMagic == NOFFMAGIC);
-
-    // how big is address space?
-    size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; // we need to increase the size
-                                                                                          // to leave room for the stack
-    numPages = divRoundUp(size, PageSize);
+    restoring = (noffH.noffMagic == CheckpointMagic);
+    if (restoring)
+        ReadCheckpoint();
+    else
+    {
+        if ((noffH.noffMagic != NOFFMAGIC) &&
+            (WordToHost(noffH.noffMagic) == NOFFMAGIC))
+            SwapHeader(&noffH);
+        ASSERT(noffH.noffMagic == NOFFMAGIC);
+
+        // how big is address space?
+        size = noffH.code.size + noffH.initData.size + noffH.uninitData.size + UserStackSize; // we need to increase the size
+                                                                                              // to leave room for the stack
+        numPages = divRoundUp(size, PageSize);
+    }
     size = numPages * PageSize;
 
     // ASSERT(numPages <= NumPhysPages);		// check we're not trying
@@ -93,21 +114,28 @@ AddrSpace::AddrSpace(OpenFile *executable)
         // pageTable[i].physicalPage = machine->memMap->Find();
         pageTable[i].valid = FALSE;
         pageTable[i].noSwap = FALSE;
+        pageTable[i].zeroFill = restoring && (imageOffset[i] == 0);
         // pageTable[i].use = FALSE;
         // pageTable[i].dirty = FALSE;
         // pageTable[i].readOnly = FALSE;  // if the code segment was entirely on
         // a separate page, we could set its
         // pages to be read-only
     }
+#else
+    ASSERT(!restoring); // checkpoints need page tables
 #endif
     // zero out the entire address space, to zero the unitialized data segment
     // and the stack segment
     // bzero(machine->mainMemory, size);
-    char threadName[37];
-    strncpy(threadName, currentThread->getName(), 32);
-    threadName[32] = '\0';
-    strcat(threadName, ".swap");
-    swapName = threadName;
+    swapName = new char[37];
+    if (currentThread->process != NULL)
+        sprintf(swapName, "%d.swap", currentThread->process->getPid());
+    else
+    {
+        strncpy(swapName, currentThread->getName(), 32);
+        swapName[32] = '\0';
+        strcat(swapName, ".swap");
+    }
     if (fileSystem->Create(swapName, size))
         swapFile = fileSystem->Open(swapName);
     else
@@ -116,6 +144,15 @@ AddrSpace::AddrSpace(OpenFile *executable)
         ASSERT(FALSE);
     }
 
+    residentPages = 0;
+    stackMap = new BitMap(MaxUserThreads);
+    refCount = 0;
+    if (restoring)
+    {
+        stackBase = heapStart + UserHeapSize;
+        return; // the pages stay in the checkpoint until they are needed
+    }
+
     char *tempBuff = new char[size];
     // then, copy in the code and data segments into "swap file"
     if (noffH.code.size > 0)
@@ -136,20 +173,42 @@ AddrSpace::AddrSpace(OpenFile *executable)
     }
     delete tempBuff;
     codePageNum = divRoundUp(noffH.code.size, PageSize);
+    heapStart = brk = size;
+    stackBase = heapStart + UserHeapSize;
 }
 
 //----------------------------------------------------------------------
 // AddrSpace::~AddrSpace
-// 	Dealloate an address space.  Nothing for now!
+// 	Dealloate an address space: give back the physical pages it
+//	still holds, and throw away its swap file.  The swap file must be
+//	closed before it can be removed.
 //----------------------------------------------------------------------
 
 AddrSpace::~AddrSpace()
 {
 #ifndef USE_TLB
-    delete pageTable;
-    fileSystem->Remove(swapName);
+    for (unsigned int i = 0; i < numPages; i++)
+        if (pageTable[i].valid)
+            machine->memMap->Clear(pageTable[i].physicalPage);
+    if (machine->pageTable == pageTable)
+        machine->pageTable = NULL;
+    delete[] pageTable;
     delete swapFile;
+    fileSystem->Remove(swapName);
+#endif
+    delete[] swapName;
+    delete stackMap;
+    delete image;
+    delete[] imageOffset;
+    delete[] savedRegisters;
+    if (loadedSpace == this)
+    {
+#ifdef USE_TLB
+        for (int i = 0; i < TLBSize; i++)
+            machine->tlb[i].valid = FALSE;
 #endif
+        loadedSpace = NULL;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -166,6 +225,16 @@ void AddrSpace::InitRegisters()
 {
     int i;
 
+    if (savedRegisters != NULL)
+    { // restored from a checkpoint: carry on where it left off
+        for (i = 0; i < NumTotalRegs; i++)
+            machine->WriteRegister(i, savedRegisters[i]);
+        if (currentThread->process != NULL)
+            machine->WriteInfo(InfoPid, currentThread->process->getPid());
+        machine->WriteInfo(InfoTid, currentThread->getTid());
+        return;
+    }
+
     for (i = 0; i < NumTotalRegs; i++)
         machine->WriteRegister(i, 0);
 
@@ -181,6 +250,164 @@ void AddrSpace::InitRegisters()
     // accidentally reference off the end!
     machine->WriteRegister(StackReg, numPages * PageSize - 16);
     DEBUG('a', "Initializing stack register to %d\n", numPages * PageSize - 16);
+
+    // and let the program find out who it is from the kernel info page
+    if (currentThread->process != NULL)
+        machine->WriteInfo(InfoPid, currentThread->process->getPid());
+    machine->WriteInfo(InfoTid, currentThread->getTid());
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Sbrk
+// 	Grow (or shrink) the heap, which lies just above the stack, by
+//	"increment" bytes, and return the old break.
+//
+//	New pages are demand-zero: they get a page table entry but no
+//	memory and no swap space, and the page fault handler fills them
+//	with zeroes the first time they are touched.  Pages given back
+//	by a negative "increment" are freed at once.
+//
+//	Return -1 if the heap would shrink below nothing, or grow past
+//	UserHeapSize.  Only page tables are supported, not the TLB.
+//----------------------------------------------------------------------
+
+int AddrSpace::Sbrk(int increment)
+{
+#ifdef USE_TLB
+    return -1;
+#else
+    int oldBrk = brk;
+    int newBrk = brk + increment;
+
+    if (newBrk < heapStart || newBrk > heapStart + UserHeapSize)
+        return -1;
+
+    FreePages(divRoundUp(newBrk, PageSize), divRoundUp(oldBrk, PageSize));
+    brk = newBrk;
+    ResizePageTable(PagesInUse());
+    return oldBrk;
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::AllocStack
+// 	Find a stack for a new thread in this address space.  Thread
+//	stacks live in slots of UserStackSize bytes from "stackBase", out
+//	of the way of the heap however far it grows, and like the heap
+//	they are demand-zero.
+//
+//	Return the initial stack pointer, or -1 if all MaxUserThreads
+//	slots are taken (or we are using the TLB).
+//----------------------------------------------------------------------
+
+int AddrSpace::AllocStack()
+{
+#ifdef USE_TLB
+    return -1;
+#else
+    int slot = stackMap->Find();
+
+    if (slot == -1)
+        return -1;
+    ResizePageTable(PagesInUse());
+    return stackBase + (slot + 1) * UserStackSize - 16;
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FreeStack
+// 	A thread is finishing: free the pages of the stack whose initial
+//	stack pointer was "stackTop", and its slot.
+//----------------------------------------------------------------------
+
+void AddrSpace::FreeStack(int stackTop)
+{
+    int slot = (stackTop - stackBase) / UserStackSize;
+    unsigned int first = (stackBase + slot * UserStackSize) / PageSize;
+
+    ASSERT(stackMap->Test(slot));
+    FreePages(first, first + divRoundUp(UserStackSize, PageSize));
+    stackMap->Clear(slot);
+    ResizePageTable(PagesInUse());
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::PagesInUse
+// 	Return how many page table entries are needed to cover the heap
+//	and the highest thread stack in use.  Pages between the two are
+//	left demand-zero.
+//----------------------------------------------------------------------
+
+unsigned int
+AddrSpace::PagesInUse()
+{
+    for (int slot = MaxUserThreads - 1; slot >= 0; slot--)
+        if (stackMap->Test(slot))
+            return divRoundUp(stackBase + (slot + 1) * UserStackSize, PageSize);
+    return divRoundUp(brk, PageSize);
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::FreePages
+// 	Give back the physical pages behind virtual pages [from, to), and
+//	make them demand-zero again, since what is in the swap file for
+//	them is no longer wanted.
+//----------------------------------------------------------------------
+
+void AddrSpace::FreePages(unsigned int from, unsigned int to)
+{
+#ifndef USE_TLB
+    for (unsigned int i = from; i < to && i < numPages; i++)
+    {
+        if (pageTable[i].valid)
+        {
+            machine->memMap->Clear(pageTable[i].physicalPage);
+            pageTable[i].valid = FALSE;
+            residentPages--;
+        }
+        pageTable[i].zeroFill = TRUE;
+        if (i < imagePages)
+            imageOffset[i] = 0;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ResizePageTable
+// 	Grow the page table to "newPages" entries, adding demand-zero
+//	pages, or shrink it, freeing the pages cut off.  If we are the
+//	address space the machine is running, tell it.
+//----------------------------------------------------------------------
+
+void AddrSpace::ResizePageTable(unsigned int newPages)
+{
+#ifndef USE_TLB
+    unsigned int i;
+
+    if (newPages > numPages)
+    {
+        TranslationEntry *newTable = new TranslationEntry[newPages];
+        for (i = 0; i < numPages; i++)
+            newTable[i] = pageTable[i];
+        for (; i < newPages; i++)
+        {
+            newTable[i].virtualPage = i;
+            newTable[i].valid = FALSE;
+            newTable[i].readOnly = FALSE;
+            newTable[i].noSwap = FALSE;
+            newTable[i].zeroFill = TRUE;
+        }
+        if (machine->pageTable == pageTable)
+            machine->pageTable = newTable;
+        delete[] pageTable;
+        pageTable = newTable;
+    }
+    else
+        FreePages(newPages, numPages);
+    numPages = newPages;
+    if (machine->pageTable == pageTable)
+        machine->pageTableSize = numPages;
+#endif
 }
 
 //----------------------------------------------------------------------
@@ -188,7 +415,9 @@ void AddrSpace::InitRegisters()
 // 	On a context switch, save any machine state, specific
 //	to this address space, that needs saving.
 //
-//	For now, nothing!
+//	Write the dirty pages out to the swap file, give up physical
+//	memory, and uninstall the page table.  Only called, by
+//	RestoreState, when another address space is about to be loaded.
 //----------------------------------------------------------------------
 
 void AddrSpace::SaveState()
@@ -208,8 +437,12 @@ void AddrSpace::SaveState()
         }
         pageTable[i].valid = FALSE;
     }
+    residentPages = 0;
     machine->memMap->Refresh();
+    if (machine->pageTable == pageTable)
+        machine->pageTable = NULL;
 #endif
+    loadedSpace = NULL;
     //printf("Clear complete.\n");
 }
 
@@ -218,11 +451,23 @@ void AddrSpace::SaveState()
 // 	On a context switch, restore the machine state so that
 //	this address space can run.
 //
-//      For now, tell the machine where to find the page table.
+//	Switching is lazy: if we are still loaded -- because the threads
+//	that ran since were kernel-only, or were our own -- there is
+//	nothing to do.  Otherwise save whoever is loaded, tell the machine
+//	where to find our page table, and bring the code back into memory.
 //----------------------------------------------------------------------
 
 void AddrSpace::RestoreState()
 {
+    if (loadedSpace == this)
+    {
+        stats->numSpaceSwitchesAvoided++;
+        return;
+    }
+    if (loadedSpace != NULL)
+        loadedSpace->SaveState();
+    loadedSpace = this;
+    stats->numSpaceSwitches++;
 #ifndef USE_TLB
     //printf("Restore state of thread \"%s\"\n", currentThread->getName());
     //PrintThreadStates();
@@ -244,8 +489,152 @@ void AddrSpace::RestoreState()
         pageTable[i].dirty = FALSE;
         pageTable[i].readOnly = FALSE;
         pageTable[i].noSwap = TRUE;
-        swapFile->ReadAt(&(machine->mainMemory[ppn * PageSize]), PageSize, i * PageSize);
+        LoadPage(i, ppn);
+        residentPages++;
     }
+    if (currentThread->process != NULL)
+        currentThread->process->usage.NoteResident(residentPages);
     //printf("Restore complete.\n");
 #endif
 }
+
+//----------------------------------------------------------------------
+// AddrSpace::ReadPage
+// 	Copy the contents of virtual page "vpn", which is not in memory,
+//	to "into": zeroes for a demand-zero page, the page from the
+//	checkpoint we were restored from if it has not been touched since,
+//	and otherwise what was last written to the swap file.
+//----------------------------------------------------------------------
+
+void AddrSpace::ReadPage(unsigned int vpn, char *into)
+{
+#ifndef USE_TLB
+    if (pageTable[vpn].zeroFill)
+        bzero(into, PageSize);
+    else if (vpn < imagePages && imageOffset[vpn] != 0)
+        image->ReadAt(into, PageSize, imageOffset[vpn]);
+    else
+        swapFile->ReadAt(into, PageSize, vpn * PageSize);
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::LoadPage
+// 	Bring virtual page "vpn" into physical page "ppn".  A page that
+//	did not come from the swap file is marked dirty, so that it is
+//	written there when it is next thrown out.
+//----------------------------------------------------------------------
+
+void AddrSpace::LoadPage(unsigned int vpn, int ppn)
+{
+#ifndef USE_TLB
+    ReadPage(vpn, &(machine->mainMemory[ppn * PageSize]));
+    if (pageTable[vpn].zeroFill || (vpn < imagePages && imageOffset[vpn] != 0))
+    {
+        pageTable[vpn].zeroFill = FALSE;
+        if (vpn < imagePages)
+            imageOffset[vpn] = 0;
+        pageTable[vpn].dirty = TRUE;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::Checkpoint
+// 	Save this address space, and the user registers "registers" of
+//	its one thread, to the file "fileName", so that Exec'ing the file
+//	carries on from there (see the constructor).  The file holds a
+//	CheckpointHeader, then the file offset of every page (0 for one
+//	that is all zeroes), then the pages themselves, in host byte
+//	order.
+//
+//	Open files are not saved: the restored process starts with just
+//	the console.
+//
+//	Return FALSE if the file cannot be written, or with the TLB.
+//----------------------------------------------------------------------
+
+bool AddrSpace::Checkpoint(char *fileName, int *registers)
+{
+#ifdef USE_TLB
+    return FALSE;
+#else
+    CheckpointHeader header;
+    int *offsets = new int[numPages];
+    int fileSize = sizeof(header) + numPages * sizeof(int);
+    unsigned int i;
+
+    for (i = 0; i < numPages; i++)
+        if (pageTable[i].zeroFill)
+            offsets[i] = 0;
+        else
+        {
+            offsets[i] = fileSize;
+            fileSize += PageSize;
+        }
+
+    fileSystem->Remove(fileName); // replace any older checkpoint
+    OpenFile *file = NULL;
+    if (fileSystem->Create(fileName, fileSize))
+        file = fileSystem->Open(fileName);
+    if (file == NULL)
+    {
+        delete[] offsets;
+        return FALSE;
+    }
+
+    header.magic = CheckpointMagic;
+    header.numPages = numPages;
+    header.codePageNum = codePageNum;
+    header.heapStart = heapStart;
+    header.brk = brk;
+    for (i = 0; i < NumTotalRegs; i++)
+        header.registers[i] = registers[i];
+    file->WriteAt((char *)&header, sizeof(header), 0);
+    file->WriteAt((char *)offsets, numPages * sizeof(int), sizeof(header));
+
+    char *page = new char[PageSize];
+    for (i = 0; i < numPages; i++)
+    {
+        if (offsets[i] == 0)
+            continue;
+        if (pageTable[i].valid)
+            file->WriteAt(&(machine->mainMemory[pageTable[i].physicalPage * PageSize]),
+                          PageSize, offsets[i]);
+        else
+        {
+            ReadPage(i, page);
+            file->WriteAt(page, PageSize, offsets[i]);
+        }
+    }
+    delete[] page;
+    delete[] offsets;
+    delete file;
+    return TRUE;
+#endif
+}
+
+//----------------------------------------------------------------------
+// AddrSpace::ReadCheckpoint
+// 	Set up the size, layout and registers of an address space from
+//	the header of the checkpoint in "image".  The page offsets are
+//	kept, so that each page can be read in the first time it is used.
+//----------------------------------------------------------------------
+
+void AddrSpace::ReadCheckpoint()
+{
+    CheckpointHeader header;
+
+    image->ReadAt((char *)&header, sizeof(header), 0);
+    numPages = imagePages = header.numPages;
+    codePageNum = header.codePageNum;
+    heapStart = header.heapStart;
+    brk = header.brk;
+    savedRegisters = new int[NumTotalRegs];
+    for (int i = 0; i < NumTotalRegs; i++)
+        savedRegisters[i] = header.registers[i];
+    imageOffset = new int[numPages];
+    image->ReadAt((char *)imageOffset, numPages * sizeof(int), sizeof(header));
+    DEBUG('a', "Restoring address space from a checkpoint, num pages %d\n",
+          numPages);
+}
@@ -15,35 +15,99 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "bitmap.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
+#define UserHeapSize		(32 * 1024)	// most a program may Sbrk
+#define MaxUserThreads		8	// Fork'ed threads per address space,
+					// each with its own stack
+
+#define CheckpointMagic		0x434b5054	// "CKPT": the file is a
+					// checkpoint, not a NOFF program
+
+// The header of a checkpoint file.  It is followed by the file offset
+// of each of the "numPages" pages (0 for a page of zeroes, which is not
+// stored), and then by the pages themselves.
+
+struct CheckpointHeader {
+    int magic;				// CheckpointMagic
+    int numPages;
+    int codePageNum;
+    int heapStart;
+    int brk;
+    int registers[NumTotalRegs];	// user registers to resume with
+};
 
 class AddrSpace {
   public:
 	AddrSpace(OpenFile *executable);	// Create an address space,
 					// initializing it with the program
 					// stored in the file "executable"
-	AddrSpace(AddrSpace *space)
-	{
-		memcpy(this, space, sizeof(AddrSpace));
-	}
 	~AddrSpace();			// De-allocate an address space
 
+	void Attach() { refCount++; }	// another thread runs in us
+	bool Detach() { return (--refCount == 0); }
+					// a thread has left; TRUE if it
+					// was the last, and we can go
+
 	void InitRegisters();		// Initialize user-level CPU registers,
 					// before jumping to user code
 
 	void SaveState();			// Save/restore address space-specific
 	void RestoreState();		// info on a context switch 
+
+	int Sbrk(int increment);	// Move the break by "increment" bytes;
+					// return the old break, or -1
+	bool Checkpoint(char *fileName, int *registers);
+					// Save us and the "registers" of our
+					// only thread to "fileName"
+	void LoadPage(unsigned int vpn, int ppn);
+					// Bring page "vpn" into frame "ppn"
+
+	int AllocStack();		// Give a new thread a stack of its
+					// own; return its top, or -1
+	void FreeStack(int stackTop);	// The thread is done with it
 	/* lab4 begin */
 	OpenFile *swapFile;
 	char *swapName;
 	int codePageNum;
+	int residentPages;		// pages now in physical memory
 	/* lab4 end */
+	int heapStart;			// first byte past the stack, where
+					// the heap begins
+	int brk;			// end of the heap
+	int stackBase;			// thread stacks start here, past
+					// the largest heap
 
 	TranslationEntry *pageTable;	// Assume linear page table translation
 					// for now!
 	unsigned int numPages;		// Number of pages in the virtual 
 					// address space
+
+  private:
+	void ResizePageTable(unsigned int newPages);
+					// Grow with demand-zero pages, or
+					// shrink, to "newPages" entries
+	void FreePages(unsigned int from, unsigned int to);
+					// Give back pages [from, to), and
+					// make them demand-zero again
+	unsigned int PagesInUse();	// Entries needed to cover the heap
+					// and every thread stack
+	void ReadCheckpoint();		// Set us up from the checkpoint
+					// header in "image"
+	void ReadPage(unsigned int vpn, char *into);
+					// Copy page "vpn" from wherever it is
+					// kept while not in memory
+
+	OpenFile *image;		// the program or checkpoint we came from
+	int *imageOffset;		// where each page is in "image", if it
+					// is still to be read from there; else 0
+	unsigned int imagePages;	// entries in "imageOffset"
+	int *savedRegisters;		// registers to start with, if restored
+					// from a checkpoint
+
+	int refCount;			// threads running in us
+	BitMap *stackMap;		// thread stack slots in use
 };
 
 #endif // ADDRSPACE_H
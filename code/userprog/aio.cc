@@ -0,0 +1,231 @@
+// aio.cc
+//	Routines to queue asynchronous file I/O to a kernel worker thread,
+//	and to collect the results.  See aio.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "aio.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// AioRequest::AioRequest
+// 	Set up a request to transfer "size" bytes between the user buffer
+//	"vaddr" and "file", at offset "position".  The kernel buffer is
+//	allocated here; the caller fills it in for a write.
+//----------------------------------------------------------------------
+
+AioRequest::AioRequest(Process *ownerProcess, OpenFile *openFile, int userAddr,
+                       int numBytes, int filePosition, bool isRead)
+{
+    owner = ownerProcess;
+    file = openFile;
+    vaddr = userAddr;
+    size = numBytes;
+    position = filePosition;
+    reading = isRead;
+    buffer = new char[size];
+    result = 0;
+    done = FALSE;
+}
+
+AioRequest::~AioRequest()
+{
+    delete[] buffer;
+}
+
+//----------------------------------------------------------------------
+// AioWorker
+// 	The body of the I/O worker thread.
+//----------------------------------------------------------------------
+
+static void AioWorker(int arg)
+{
+    ((AioManager *)arg)->Serve();
+}
+
+//----------------------------------------------------------------------
+// AioManager::AioManager
+// 	Initialize an empty request table.  The worker thread is not
+//	started until somebody actually uses asynchronous I/O.
+//----------------------------------------------------------------------
+
+AioManager::AioManager()
+{
+    for (int i = 0; i < MaxAioRequests; i++)
+        requests[i] = NULL;
+    ids = new BitMap(MaxAioRequests);
+    queue = new SynchList;
+    lock = new Lock("aio table");
+    finished = new Condition("aio finished");
+    worker = NULL;
+}
+
+AioManager::~AioManager()
+{
+    for (int i = 0; i < MaxAioRequests; i++)
+        delete requests[i];
+    delete ids;
+    delete queue;
+    delete lock;
+    delete finished;
+}
+
+//----------------------------------------------------------------------
+// AioManager::Submit
+// 	Enter "request" in the table and queue it for the worker.
+//	Return its id, or -1 (and leave "request" to the caller) if too
+//	many requests are already outstanding.
+//----------------------------------------------------------------------
+
+int AioManager::Submit(AioRequest *request)
+{
+    lock->Acquire();
+    int id = ids->Find();
+    if (id != -1)
+        requests[id] = request;
+    lock->Release();
+    if (id == -1)
+        return -1;
+
+    if (worker == NULL)
+    {
+        worker = new Thread("aio worker");
+        worker->Fork(AioWorker, (void *)this);
+    }
+    queue->Append((void *)request);
+    return id;
+}
+
+//----------------------------------------------------------------------
+// AioManager::Find
+// 	Return request "id", or NULL if there is no such request or it
+//	belongs to another process.
+//----------------------------------------------------------------------
+
+AioRequest *
+AioManager::Find(int id)
+{
+    if (id < 0 || id >= MaxAioRequests || requests[id] == NULL ||
+        requests[id]->owner != currentThread->process)
+        return NULL;
+    return requests[id];
+}
+
+//----------------------------------------------------------------------
+// AioManager::Reap
+// 	Free the finished request "id" and its id.
+//----------------------------------------------------------------------
+
+void AioManager::Reap(int id)
+{
+    lock->Acquire();
+    ASSERT(requests[id] != NULL && requests[id]->done);
+    delete requests[id];
+    requests[id] = NULL;
+    ids->Clear(id);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// AioManager::WaitAny
+// 	Block until at least one of the "count" requests in "ids" has
+//	finished, and return its index in "ids".  Return -1 at once if
+//	one of them is not a request of the current process.
+//----------------------------------------------------------------------
+
+int AioManager::WaitAny(int *idList, int count)
+{
+    int index = -1;
+
+    lock->Acquire();
+    while (index == -1)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            AioRequest *request = Find(idList[i]);
+            if (request == NULL)
+            {
+                lock->Release();
+                return -1;
+            }
+            if (request->done)
+            {
+                index = i;
+                break;
+            }
+        }
+        if (index == -1)
+            finished->Wait(lock);
+    }
+    lock->Release();
+    return index;
+}
+
+//----------------------------------------------------------------------
+// AioManager::Drain
+// 	Wait until the worker has finished every request of "owner" -- or
+//	just those on "file", if it is not NULL -- so that the file can
+//	safely be closed.  Requests on other files go on undisturbed.
+//----------------------------------------------------------------------
+
+void AioManager::Drain(Process *owner, OpenFile *file)
+{
+    lock->Acquire();
+    for (int i = 0; i < MaxAioRequests; i++)
+        while (requests[i] != NULL && requests[i]->owner == owner &&
+               (file == NULL || requests[i]->file == file) &&
+               !requests[i]->done)
+            finished->Wait(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// AioManager::Release
+// 	"owner" is exiting: wait for its requests, then throw them away
+//	whether or not it ever collected them.
+//----------------------------------------------------------------------
+
+void AioManager::Release(Process *owner)
+{
+    Drain(owner);
+    for (int i = 0; i < MaxAioRequests; i++)
+        if (requests[i] != NULL && requests[i]->owner == owner)
+            Reap(i);
+}
+
+//----------------------------------------------------------------------
+// AioManager::Serve
+// 	Take requests off the queue one at a time and do the I/O,
+//	blocking on the disk in place of the process that asked for it.
+//	While it does, the worker runs on the owner's behalf, so the disk
+//	I/O and kernel time are charged to the owner's usage.  It lets go
+//	before marking the request done, since the owner may exit as soon
+//	as it is.
+//----------------------------------------------------------------------
+
+void AioManager::Serve()
+{
+    for (;;)
+    {
+        AioRequest *request = (AioRequest *)queue->Remove();
+
+        currentThread->process = request->owner;
+        int result;
+        if (request->reading)
+            result = request->file->ReadAt(request->buffer, request->size,
+                                           request->position);
+        else
+            result = request->file->WriteAt(request->buffer, request->size,
+                                            request->position);
+        currentThread->process = NULL;
+
+        lock->Acquire();
+        request->result = max(result, 0);
+        request->done = TRUE;
+        finished->Broadcast(lock);
+        lock->Release();
+    }
+}
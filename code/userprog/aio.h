@@ -0,0 +1,87 @@
+// aio.h
+//	Data structures for asynchronous file I/O.
+//
+//	AioRead and AioWrite hand a request to a kernel I/O worker thread
+//	and return at once with a small request id; the user program keeps
+//	computing while the worker blocks on the disk.  The program later
+//	collects the result with AioPoll, or blocks in AioWait until one
+//	of a set of requests has finished.
+//
+//	The worker cannot touch user memory, since it does not run in the
+//	requesting process' address space.  So AioWrite copies the user's
+//	data into the request's kernel buffer before queueing it, and the
+//	data of an AioRead is copied out to the user's buffer when the
+//	request is collected.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef AIO_H
+#define AIO_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "openfile.h"
+#include "bitmap.h"
+#include "synch.h"
+#include "synchlist.h"
+
+#define MaxAioRequests 32       // requests outstanding at once, system-wide
+#define MaxAioBytes (16 * 1024) // largest single request
+
+class Process;
+class Thread;
+
+// One queued read or write.  Filled in by the syscall handler; "result"
+// and "done" are set by the worker.
+class AioRequest
+{
+  public:
+    AioRequest(Process *owner, OpenFile *file, int vaddr, int size,
+               int position, bool reading);
+    ~AioRequest();
+
+    Process *owner; // process that issued the request
+    OpenFile *file; // file to read or write
+    int vaddr;      // user buffer
+    int size;       // bytes requested
+    int position;   // offset in "file"
+    bool reading;   // AioRead or AioWrite?
+    char *buffer;   // kernel copy of the data
+    int result;     // bytes transferred, once done
+    bool done;      // has the worker finished with it?
+};
+
+// The table of outstanding requests, and the worker that serves them.
+class AioManager
+{
+  public:
+    AioManager();
+    ~AioManager();
+
+    int Submit(AioRequest *request); // queue "request"; return its id,
+                                     // or -1 if the table is full
+    AioRequest *Find(int id);        // the request "id", if the current
+                                     // process issued it, else NULL
+    void Reap(int id);               // forget the finished request "id"
+    int WaitAny(int *ids, int count); // wait until one of "ids" is done;
+                                      // return its index in "ids"
+
+    void Drain(Process *owner, OpenFile *file = NULL);
+                                  // wait for "owner"'s requests (on
+                                  // "file" only, if given) to finish
+    void Release(Process *owner); // Drain, then forget all of them
+
+    void Serve(); // the worker's loop; never returns
+
+  private:
+    AioRequest *requests[MaxAioRequests];
+    BitMap *ids;          // which entries of "requests" are in use
+    SynchList *queue;     // requests not yet started by the worker
+    Lock *lock;           // protects "requests" and their "done" flags
+    Condition *finished;  // signalled whenever a request completes
+    Thread *worker;       // created on the first Submit
+};
+
+#endif // AIO_H
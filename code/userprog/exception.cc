@@ -26,6 +26,14 @@
 #include "system.h"
 #include "syscall.h"
 #include "addrspace.h"
+#include "disk.h"
+#ifdef FILESYS
+#include "directory.h"
+#include "filehdr.h"
+#endif
+
+#define IOChunkSize (32 * SectorSize) // bytes moved per step of Read/Write
+#define MaxIoVec 16                   // most segments in one ReadV/WriteV
 
 void SyscallEnd(int type)
 {
@@ -66,8 +74,13 @@ void SyscallEnd(int type)
 
 void fork_func(int arg)
 {
+	// a new thread never returns from SWITCH in Scheduler::Run, so
+	// load its state here
+	currentThread->RestoreUserState();
+	currentThread->space->RestoreState();
 	machine->WriteRegister(PCReg, arg);
 	machine->WriteRegister(NextPCReg, arg + 4);
+	machine->WriteRegister(StackReg, currentThread->userStack);
 	machine->Run();
 }
 
@@ -76,436 +89,834 @@ void exec_func(int arg)
 	OpenFile *openFile = (OpenFile *)arg;
 
 	currentThread->space = new AddrSpace(openFile);
+	currentThread->process->space = currentThread->space;
+	currentThread->space->Attach();	// which keeps "openFile"
 	currentThread->space->InitRegisters();
 	currentThread->space->RestoreState();
 	machine->Run();
 }
 
+//----------------------------------------------------------------------
+// HandlePageFault
+// 	Bring the page holding "badVAddr" in: refill the TLB, or (with a
+//	linear page table) find it a physical page, evicting the least
+//	recently used one if need be, and load its contents.  Called for a
+//	page fault raised by a user instruction, and by CopyUser when a
+//	system call touches a page that is not in memory.
+//----------------------------------------------------------------------
+
+static void HandlePageFault(int badVAddr)
+{
+	int i;
+	unsigned int vpn;
+
+	vpn = (unsigned)badVAddr / PageSize;
+	// use TLB
+	if (machine->tlb != NULL)
+	{
+		currentThread->process->usage.tlbMisses++;
+		for (i = 0; i < TLBSize; ++i)
+		{
+			if (machine->tlb[i].valid == false)
+			{
+				machine->tlb[i].valid = true;
+				machine->tlb[i].interval = 0;
+				if (i == 0)
+					machine->tlb[0].replace = true;
+				machine->tlb[i].virtualPage = machine->tlb[i].physicalPage = vpn;
+				break;
+			}
+		}
+		if (i == TLBSize)
+		{
+#ifdef LRU
+			int LRUid, max_intv = -1;
+			for (i = 0; i < TLBSize; ++i)
+			{
+				if (machine->tlb[i].interval > max_intv)
+				{
+					LRUid = i;
+					max_intv = machine->tlb[i].interval;
+				}
+			}
+			machine->tlb[LRUid].interval = 0;
+			machine->tlb[LRUid].virtualPage = machine->tlb[LRUid].physicalPage = vpn;
+#else
+			int FIFOid;
+			for (i = 0; i < TLBSize; ++i)
+			{
+				if (machine->tlb[i].replace)
+				{
+					FIFOid = i;
+					machine->tlb[i].replace = false;
+					machine->tlb[(i + 1) % TLBSize].replace = true;
+					break;
+				}
+			}
+			machine->tlb[FIFOid].virtualPage = machine->tlb[FIFOid].physicalPage = vpn;
+#endif
+		}
+	}
+	// use pagetable
+	else
+	{
+		TranslationEntry *ptable = currentThread->space->pageTable;
+		int ppn;
+		int LRUid, max_intv = -1;
+		int npages = currentThread->space->numPages;
+
+		stats->numPageFaults++;
+		currentThread->process->usage.pageFaults++;
+		// Need replace(LRU)
+		if ((ppn = machine->memMap->Find()) != -1)
+			currentThread->space->residentPages++;
+		else
+		{
+			int poffset, voffset;
+			for (int i = 0; i < npages; ++i)
+			{
+				if (ptable[i].valid && (!ptable[i].noSwap) && (ptable[i].interval > max_intv))
+				{
+					max_intv = ptable[i].interval;
+					LRUid = i;
+				}
+			}
+			//printf("New vpn %d replace vpn %d in ppn %d\n", vpn, LRUid, ptable[LRUid].physicalPage);
+			if (ptable[LRUid].dirty)
+			{
+				poffset = ptable[LRUid].physicalPage * PageSize;
+				voffset = ptable[LRUid].virtualPage * PageSize;
+				currentThread->space->swapFile->WriteAt(&(machine->mainMemory[poffset]), PageSize, voffset);
+			}
+			ptable[LRUid].valid = FALSE;
+			ppn = ptable[LRUid].physicalPage;
+		}
+		//printf("Place vpn %d in ppn %d\n", vpn, ppn);
+		ptable[vpn].virtualPage = vpn;
+		ptable[vpn].physicalPage = ppn;
+		ptable[vpn].dirty = FALSE;
+		ptable[vpn].valid = TRUE;
+		ptable[vpn].use = TRUE;
+		ptable[vpn].interval = 0;
+		currentThread->space->LoadPage(vpn, ppn);
+		currentThread->process->usage.NoteResident(currentThread->space->residentPages);
+	}
+}
+
+//----------------------------------------------------------------------
+// CopyUser
+// 	Move "size" bytes between the user address "vaddr" and the kernel
+//	buffer "buf" -- into "buf" if "toKernel", out of it otherwise.
+//	The copy goes one page at a time: each page is translated once and
+//	moved with bcopy, rather than a ReadMem/WriteMem call per byte.  If
+//	the page is not in memory (or not in the TLB), bring it in with
+//	HandlePageFault and try again.  With a NULL "buf", nothing is
+//	copied: the range is only checked, and its pages brought in.
+//
+//	Return FALSE if part of the range is not a legal address.
+//----------------------------------------------------------------------
+
+static bool CopyUser(int vaddr, char *buf, int size, bool toKernel)
+{
+	while (size > 0)
+	{
+		int physAddr;
+		ExceptionType exception = machine->Translate(vaddr, &physAddr, 1, !toKernel);
+		if (exception == PageFaultException)
+		{
+			HandlePageFault(vaddr); // stay in SystemMode, and leave the
+			continue;				// user's registers alone
+		}
+		if (exception != NoException)
+			return FALSE;
+
+		int piece = min(size, PageSize - (vaddr % PageSize));
+		if (buf != NULL)
+		{
+			if (toKernel)
+				bcopy(&machine->mainMemory[physAddr], buf, piece);
+			else
+				bcopy(buf, &machine->mainMemory[physAddr], piece);
+			buf += piece;
+		}
+		vaddr += piece;
+		size -= piece;
+	}
+	return TRUE;
+}
+
+//----------------------------------------------------------------------
+// ReadUserPath
+// 	Fetch the file name at user address "vaddr" and resolve it against
+//	the current process' working directory, leaving a path from the
+//	root of the file system in "path" (MAX_PATH_LEN bytes).  Return
+//	FALSE for a bad address or a name that is too long.
+//----------------------------------------------------------------------
+
+static bool ReadUserPath(int vaddr, char *path)
+{
+	char name[MAX_PATH_LEN];
+
+	for (int i = 0; i < MAX_PATH_LEN; i++)
+	{
+		if (!CopyUser(vaddr + i, &name[i], 1, TRUE))
+			return FALSE;
+		if (name[i] == '\0')
+			return currentThread->process->ResolvePath(name, path);
+	}
+	return FALSE;
+}
+
+//----------------------------------------------------------------------
+// Transfer
+// 	Read (or write) "size" bytes of the user buffer at "vaddr" from (or
+//	to) the open file "fd", for Read, Write, ReadV and WriteV.
+//
+//	The data is streamed through one fixed-size kernel buffer in
+//	IOChunkSize pieces, so a transfer of any size needs no more kernel
+//	memory than that.  After the first piece, every piece starts on a
+//	sector boundary of the file, so the file system never has to
+//	read-modify-write a sector more than once.
+//
+//	A read from the console returns at most one line.  Only the
+//	calling thread waits for it to be typed, and a write only waits
+//	for room in the console's output buffer (see SynchConsole).  A
+//	read from a pipe likewise returns what the pipe holds, once there
+//	is anything; a write to one waits until all of it is taken in.
+//
+//	Return the number of bytes transferred, which is short at end of
+//	file or at a bad user address, or -1 if "fd" cannot be used.
+//----------------------------------------------------------------------
+
+static int Transfer(int fd, int vaddr, int size, bool reading)
+{
+	OpenFile *openFile = NULL;
+
+	if (fd == ConsoleInput || fd == ConsoleOutput)
+	{
+		if ((fd == ConsoleInput) != reading)
+			return -1;
+	}
+	else if ((openFile = currentThread->process->GetFile(fd)) == NULL)
+		return -1;
+
+	// a read returns what is there now: a line of the console, or
+	// whatever a pipe holds
+	bool partial = (openFile == NULL);
+#ifdef FILESYS
+	if (openFile != NULL && openFile->usePipe)
+		partial = TRUE;
+#endif
+
+	char *chunk = new char[IOChunkSize];
+	int done = 0;
+	while (done < size)
+	{
+		int count = min(size - done, IOChunkSize);
+		if (openFile != NULL)
+			count = min(count, IOChunkSize - openFile->Tell() % SectorSize);
+
+		int numBytes;
+		if (reading)
+		{
+			// check where the data is to go before taking it: once
+			// read, it cannot be put back into a pipe or the console
+			if (!CopyUser(vaddr + done, NULL, count, FALSE))
+				break;
+			if (openFile != NULL)
+				numBytes = max(openFile->Read(chunk, count), 0);
+			else
+				numBytes = synchConsole->ReadLine(chunk, count);
+			if (!CopyUser(vaddr + done, chunk, numBytes, FALSE))
+				break;
+		}
+		else
+		{
+			if (!CopyUser(vaddr + done, chunk, count, TRUE))
+				break;
+			if (openFile != NULL)
+				numBytes = max(openFile->Write(chunk, count), 0);
+			else
+			{
+				synchConsole->Write(chunk, count);
+				numBytes = count;
+			}
+		}
+		done += numBytes;
+		if (numBytes < count) // end of file
+			break;
+		if (reading && partial)
+			break;
+	}
+	delete[] chunk;
+	return done;
+}
+
+//----------------------------------------------------------------------
+// TransferV
+// 	ReadV/WriteV: fetch the "iovcnt" IoVec records at "iovAddr" from
+//	user memory, then Transfer each segment in turn.  Stop at the first
+//	short segment.  Return the total, or -1 for a bad fd or IoVec array.
+//----------------------------------------------------------------------
+
+static int TransferV(int fd, int iovAddr, int iovcnt, bool reading)
+{
+	int iov[2 * MaxIoVec]; // buf, len pairs
+
+	if (iovcnt < 0 || iovcnt > MaxIoVec ||
+		!CopyUser(iovAddr, (char *)iov, iovcnt * sizeof(IoVec), TRUE))
+		return -1;
+
+	int total = 0;
+	for (int i = 0; i < iovcnt; i++)
+	{
+		int buf = WordToHost(iov[2 * i]);
+		int len = WordToHost(iov[2 * i + 1]);
+		int numBytes = Transfer(fd, buf, len, reading);
+		if (numBytes < 0)
+			return (i == 0) ? -1 : total;
+		total += numBytes;
+		if (numBytes < len)
+			break;
+	}
+	return total;
+}
+
+//----------------------------------------------------------------------
+// CopyBetween
+// 	CopyFile: copy up to "len" bytes of the open file "srcFd", starting
+//	at "offset", to the current position of "dstFd".  The data never
+//	goes near user memory; it is moved with ReadAt/Write through one
+//	kernel buffer, in pieces that start on sector boundaries of the
+//	source file.  The source's own position is left alone.
+//
+//	Return the number of bytes copied (short if the source ends
+//	first), or -1 if either fd is not an open file.
+//----------------------------------------------------------------------
+
+static int CopyBetween(int srcFd, int dstFd, int offset, int len)
+{
+	OpenFile *src = currentThread->process->GetFile(srcFd);
+	OpenFile *dst = currentThread->process->GetFile(dstFd);
+
+	if (src == NULL || dst == NULL || offset < 0 || len < 0)
+		return -1;
+#ifdef FILESYS
+	if (src->usePipe) // a pipe has no offsets to read at
+		return -1;
+#endif
+
+	char *chunk = new char[IOChunkSize];
+	int done = 0;
+	while (done < len)
+	{
+		int count = min(len - done, IOChunkSize - (offset + done) % SectorSize);
+		int numRead = max(src->ReadAt(chunk, count, offset + done), 0);
+		int numWrite = dst->Write(chunk, numRead);
+		done += numWrite;
+		if (numRead < count || numWrite < numRead) // end of file
+			break;
+	}
+	delete[] chunk;
+	return done;
+}
+
+//----------------------------------------------------------------------
+// AioSubmit
+// 	AioRead/AioWrite: queue a transfer of "size" bytes between the user
+//	buffer "vaddr" and the open file "fd", at the file's current
+//	position, and move that position past it so that the next call
+//	picks up where this one leaves off.  For a write, the data is
+//	copied out of user memory now, so the program may reuse its buffer
+//	at once.  Return the request id, or -1.
+//----------------------------------------------------------------------
+
+static int AioSubmit(int fd, int vaddr, int size, bool reading)
+{
+	OpenFile *openFile = currentThread->process->GetFile(fd);
+
+	if (openFile == NULL || size < 0 || size > MaxAioBytes)
+		return -1;
+#ifdef FILESYS
+	if (openFile->usePipe)
+		return -1;
+#endif
+
+	AioRequest *request = new AioRequest(currentThread->process, openFile,
+										 vaddr, size, openFile->Tell(), reading);
+	if (!reading && !CopyUser(vaddr, request->buffer, size, TRUE))
+	{
+		delete request;
+		return -1;
+	}
+	int id = aioManager->Submit(request);
+	if (id == -1)
+		delete request;
+	else
+		openFile->Seek(request->position + size);
+	return id;
+}
+
+//----------------------------------------------------------------------
+// AioCollect
+// 	AioPoll: if request "id" has finished, copy the data of a read out
+//	to the user's buffer, free the request, and return the number of
+//	bytes transferred.  Return AioPending if it is still in progress,
+//	or -1 if it is not one of ours.
+//----------------------------------------------------------------------
+
+static int AioCollect(int id)
+{
+	AioRequest *request = aioManager->Find(id);
+
+	if (request == NULL)
+		return -1;
+	if (!request->done)
+		return AioPending;
+
+	int result = request->result;
+	if (request->reading && !CopyUser(request->vaddr, request->buffer, result, FALSE))
+		result = -1;
+	aioManager->Reap(id);
+	return result;
+}
+
+//----------------------------------------------------------------------
+// ReadDirEntries
+// 	ReadDir: copy up to "n" entries of the directory open as "fd" to
+//	the DirEnt array at "vaddr".  The file's position counts directory
+//	slots rather than bytes, so that each call picks up after the last
+//	entry returned by the one before.  The directory is fetched from
+//	disk once per call, however many entries are returned.
+//
+//	Return the number of entries copied (0 at the end of the
+//	directory), or -1 if "fd" is not an open directory.
+//----------------------------------------------------------------------
+
+static int ReadDirEntries(int fd, int vaddr, int n)
+{
+#ifdef FILESYS
+	OpenFile *openFile = currentThread->process->GetFile(fd);
+
+	if (openFile == NULL || !openFile->IsDirectory() || n < 0)
+		return -1;
+
+	Directory *directory = new Directory(NumDirEntries);
+	FileHeader *hdr = new FileHeader;
+	DirEnt entry;
+	int slot = openFile->Tell();
+	int count = 0;
+
+	directory->FetchFrom(openFile);
+	for (; slot < NumDirEntries && count < n; slot++)
+	{
+		DirectoryEntry dirEntry = directory->GetEntry(slot);
+		if (!dirEntry.inUse)
+			continue;
+		if (dirEntry.short_name)
+			strcpy(entry.name, dirEntry.name);
+		else
+			directory->GetLongName(entry.name, slot);
+		hdr->FetchFrom(dirEntry.sector);
+		entry.isDir = WordToMachine(hdr->GetIfDir() ? 1 : 0);
+		if (!CopyUser(vaddr + count * sizeof(DirEnt), (char *)&entry,
+					  sizeof(DirEnt), FALSE))
+			break;
+		count++;
+	}
+	openFile->Seek(slot);
+	delete hdr;
+	delete directory;
+	return count;
+#else
+	return -1; // the UNIX stub file system cannot open directories
+#endif
+}
+
+//----------------------------------------------------------------------
+// OpenPipe
+// 	MakePipe: create a new pipe, open its read end and its write end
+//	as two descriptors of the calling process, and store them in the
+//	user's array "vaddr" -- the read end first.  Return 0, or -1 (with
+//	nothing left open) if the fd table is full or "vaddr" is bad.
+//----------------------------------------------------------------------
+
+static int OpenPipe(int vaddr)
+{
+#ifdef FILESYS
+	Process *process = currentThread->process;
+	Pipe *pipe = new Pipe;
+	OpenFile *ends[2] = {new OpenFile(pipe, FALSE), new OpenFile(pipe, TRUE)};
+	int fds[2], userFds[2];
+
+	fds[0] = process->AllocFd(ends[0]);
+	fds[1] = (fds[0] == -1) ? -1 : process->AllocFd(ends[1]);
+	userFds[0] = WordToMachine(fds[0]);
+	userFds[1] = WordToMachine(fds[1]);
+	if (fds[1] != -1 && CopyUser(vaddr, (char *)userFds, sizeof(userFds), FALSE))
+		return 0;
+
+	for (int i = 0; i < 2; i++) // closing the last end deletes the pipe
+		if (fds[i] == -1 || !process->CloseFd(fds[i]))
+			delete ends[i];
+	return -1;
+#else
+	return -1; // pipe ends are only part of the Nachos file system
+#endif
+}
+
 void ExceptionHandler(ExceptionType which)
 {
 	int type = machine->ReadRegister(2);
 	int arg1 = machine->ReadRegister(4);
 	int arg2 = machine->ReadRegister(5);
 	int arg3 = machine->ReadRegister(6);
-
-	int i;
-	unsigned int vpn, offset;
+	int arg4 = machine->ReadRegister(7);
 
 	if (which == SyscallException)
 	{
+		int args[4] = {arg1, arg2, arg3, arg4};
+		int startTick = stats->totalTicks;
+		int result = 0; // returned to the user in r2, and traced
+
+		currentThread->process->usage.numSyscalls++;
+
 		switch (type)
 		{
 		case SC_Halt:
 		{
 			DEBUG('a', "Shutdown, initiated by user program.\n");
+			syscallTracer->Record(type, args, result, startTick);
 			interrupt->Halt();
 			break;
 		}
 		case SC_Exit:
 		{
 			DEBUG('a', "Exit call\n");
-			printf("Thread \"%s\" end with exit code %d\n", currentThread->getName(), arg1);
+			DEBUG('y', "Thread \"%s\" end with exit code %d\n", currentThread->getName(), arg1);
 #ifdef USE_TLB
 #ifdef LRU
-			printf("LRU:\n");
+			DEBUG('y', "LRU:\n");
 #else
-			printf("FIFO:\n");
+			DEBUG('y', "FIFO:\n");
 #endif
-			printf("miss number:%d, total number:%d\n", missCnt, memCnt);
-			printf("miss rate:%f\n", float(missCnt) / memCnt);
+			DEBUG('y', "miss number:%d, total number:%d\n", missCnt, memCnt);
+			DEBUG('y', "miss rate:%f\n", float(missCnt) / memCnt);
 #endif
-			PrintThreadStates();
+			if (DebugIsEnabled('y'))
+				PrintThreadStates();
+			currentThread->process->exitStatus = arg1;
+			syscallTracer->Record(type, args, arg1, startTick);
 			currentThread->Finish();
 			break;
 		}
 		case SC_Create:
 		{
-			int nameaddr = arg1;
-			int count = 0;
-			int value;
-			bool suc;
-			while (1)
+			char name[MAX_PATH_LEN];
+			if (!ReadUserPath(arg1, name))
 			{
-				suc = machine->ReadMem(nameaddr + count, 1, &value);
-				if (!suc)
-					continue;
-				count++;
-				if (value == 0)
-					break;
-			}
-			printf("Create: Filename length %d\n", count);
-			char name[count];
-			for (int i = 0; i < count; ++i)
-			{
-				machine->ReadMem(nameaddr + i, 1, &value);
-				name[i] = (char)value;
+				DEBUG('y', "Create: Bad filename\n");
+				result = -1;
+				break;
 			}
-			printf("Create: Filename \"%s\"\n", name);
-			fileSystem->Create(name, 256);
-			printf("Create completed\n");
+			DEBUG('y', "Create: Filename \"%s\"\n", name);
+			result = fileSystem->Create(name, 256) ? 0 : -1;
+			DEBUG('y', "Create completed\n");
 			break;
 		}
 		case SC_Open:
 		{
-			int nameaddr = arg1;
-			int count = 0;
-			int value;
-			bool suc;
-			// Getname
-			while (1)
+			char name[MAX_PATH_LEN];
+			if (!ReadUserPath(arg1, name))
 			{
-				suc = machine->ReadMem(nameaddr + count, 1, &value);
-				if (!suc)
-					continue;
-				count++;
-				if (value == 0)
-					break;
-			}
-			printf("Open: Filename length %d\n", count);
-			char name[count];
-			for (int i = 0; i < count; ++i)
-			{
-				machine->ReadMem(nameaddr + i, 1, &value);
-				name[i] = (char)value;
+				DEBUG('y', "Open: Bad filename\n");
+				result = -1;
+				break;
 			}
 
-			printf("Open: Filename \"%s\"\n", name);
+			DEBUG('y', "Open: Filename \"%s\"\n", name);
 			OpenFile *openFile = fileSystem->Open(name);
-			printf("Open: File pointer: %p\n", openFile);
+			int fd = -1;
 			if (!openFile)
-				printf("Open: File not existed!\n");
-			machine->WriteRegister(2, (int)openFile);
-			printf("Open completed\n");
+				DEBUG('y', "Open: File not existed!\n");
+			else if ((fd = currentThread->process->AllocFd(openFile)) == -1)
+			{
+				DEBUG('y', "Open: Too many open files!\n");
+				delete openFile;
+			}
+			DEBUG('y', "Open: File descriptor: %d\n", fd);
+			result = fd;
+			DEBUG('y', "Open completed\n");
 			break;
 		}
 		case SC_Close:
 		{
-			OpenFile *openFile = (OpenFile *)arg1;
-			printf("Close: File pointer: %p\n", openFile);
-			delete openFile;
-			printf("Close completed\n");
+			int fd = arg1;
+			DEBUG('y', "Close: File descriptor: %d\n", fd);
+			if (!currentThread->process->CloseFd(fd))
+			{
+				DEBUG('y', "Close: File not opened!\n");
+				result = -1;
+			}
+			DEBUG('y', "Close completed\n");
 			break;
 		}
 		case SC_Read:
 		{
-			int nameaddr = arg1;
-			int size = arg2;
-			int fd = arg3;
-			// printf("Read: File pointer: %p\n", fd);
-			int value;
-			char content[size];
-
-			// shell input
-			if (fd == ConsoleInput)
-			{
-				for (int i = 0; i < size; ++i)
-					content[i] = getchar();
-
-				for (int i = 0; i < size; ++i)
-				{
-					value = (int)(content[i]);
-					machine->WriteMem(nameaddr + i, 1, value);
-				}
-				break;
-			}
-
-			OpenFile *openFile = (OpenFile *)fd;
-			if (!openFile)
-				printf("Read: File not existed!\n");
+			int numRead = Transfer(arg3, arg1, arg2, TRUE);
+			if (numRead == -1)
+				DEBUG('y', "Read: File not existed!\n");
+			else if (arg3 != ConsoleInput)
+				DEBUG('y', "Read %d Bytes\n", numRead);
+			result = numRead;
+			break;
+		}
+		case SC_Write:
+		{
+			int numWrite = Transfer(arg3, arg1, arg2, FALSE);
+			if (numWrite == -1)
+				DEBUG('y', "Write: File not existed!\n");
+			else if (arg3 != ConsoleOutput)
+				DEBUG('y', "Write %d Bytes\n", numWrite);
+			result = numWrite;
+			break;
+		}
+		case SC_ReadV:
+		{
+			int numRead = TransferV(arg3, arg1, arg2, TRUE);
+			DEBUG('y', "ReadV: %d Bytes from %d segments\n", numRead, arg2);
+			result = numRead;
+			break;
+		}
+		case SC_WriteV:
+		{
+			int numWrite = TransferV(arg3, arg1, arg2, FALSE);
+			DEBUG('y', "WriteV: %d Bytes from %d segments\n", numWrite, arg2);
+			result = numWrite;
+			break;
+		}
+		case SC_CopyFile:
+		{
+			int numCopy = CopyBetween(arg1, arg2, arg3, arg4);
+			if (numCopy == -1)
+				DEBUG('y', "CopyFile: File not existed!\n");
 			else
+				DEBUG('y', "CopyFile %d Bytes\n", numCopy);
+			result = numCopy;
+			break;
+		}
+		case SC_AioRead:
+		case SC_AioWrite:
+		{
+			int id = AioSubmit(arg3, arg1, arg2, type == SC_AioRead);
+			DEBUG('y', "Aio%s: request %d, %d Bytes\n",
+				  (type == SC_AioRead) ? "Read" : "Write", id, arg2);
+			result = id;
+			break;
+		}
+		case SC_AioPoll:
+		{
+			result = AioCollect(arg1);
+			break;
+		}
+		case SC_AioWait:
+		{
+			int ids[MaxAioRequests];
+			int index = -1;
+			if (arg2 > 0 && arg2 <= MaxAioRequests &&
+				CopyUser(arg1, (char *)ids, arg2 * sizeof(int), TRUE))
 			{
-				
-				int numRead = openFile->Read(content, size);
-				printf("Read %d Bytes\n", numRead);
-				ASSERT(numRead == size);
-				content[size] = 0;
-				printf("Read \"%s\"\n", content);
-				for (int i = 0; i < size; ++i)
-				{
-					value = (int)(content[i]);
-					machine->WriteMem(nameaddr + i, 1, value);
-				}
-				machine->WriteRegister(2, numRead);
-				printf("Read completed\n");
+				for (int i = 0; i < arg2; i++)
+					ids[i] = WordToHost(ids[i]);
+				index = aioManager->WaitAny(ids, arg2);
 			}
+			result = index;
 			break;
 		}
-		case SC_Write:
+		case SC_Sbrk:
 		{
-			int nameaddr = arg1;
-			int size = arg2;
-			int fd = arg3;
-			// printf("Write: File pointer: %p\n", fd);
-			int value;
-			char content[size];
-
-			// shell output
-			if (fd == ConsoleOutput)
+			int oldBrk = currentThread->space->Sbrk(arg1);
+			DEBUG('y', "Sbrk: %d Bytes, break was 0x%x\n", arg1, oldBrk);
+			result = oldBrk;
+			break;
+		}
+		case SC_SetShare:
+		{
+			int oldTickets = currentThread->tickets;
+			if (arg1 < 1 || arg1 > MaxTickets)
 			{
-				for (int i = 0; i < size; ++i)
-				{
-					machine->ReadMem(nameaddr + i, 1, &value);
-					putchar((char)value);
-				}
+				DEBUG('y', "SetShare: Bad number of tickets %d\n", arg1);
+				result = -1;
 				break;
 			}
+			DEBUG('y', "SetShare: %d tickets, was %d\n", arg1, oldTickets);
+			currentThread->tickets = arg1;
+			result = oldTickets;
+			break;
+		}
+		case SC_Sleep:
+		{
+			DEBUG('y', "Sleep: %d ticks\n", arg1);
+			currentThread->SleepFor(arg1);
+			result = 0;
+			break;
+		}
+		case SC_MakePipe:
+		{
+			int retVal = OpenPipe(arg1);
+			DEBUG('y', "MakePipe: %s\n", retVal == 0 ? "ok" : "failed");
+			result = retVal;
+			break;
+		}
+		case SC_Checkpoint:
+		{
+			char name[MAX_PATH_LEN];
+			int registers[NumTotalRegs];
+			bool saved = FALSE;
 
-			OpenFile *openFile = (OpenFile *)fd;
-			if (!openFile)
-				printf("Write: File not existed!\n");
-			else
+			// the restored process resumes just past the syscall,
+			// seeing 1 as its result
+			for (int i = 0; i < NumTotalRegs; i++)
+				registers[i] = machine->ReadRegister(i);
+			registers[PrevPCReg] = registers[PCReg];
+			registers[PCReg] = registers[NextPCReg];
+			registers[NextPCReg] += 4;
+			registers[2] = 1;
+			if (!ReadUserPath(arg1, name))
 			{
-				for (int i = 0; i < size; ++i)
-				{
-					machine->ReadMem(nameaddr + i, 1, &value);
-					content[i] = (char)value;
-				}
-				printf("Write \"%s\"\n", content);
-				int numWrite = openFile->Write(content, size);
-				printf("Write %d Bytes\n", numWrite);
-				ASSERT(numWrite == size);
-				printf("Write completed\n");
+				DEBUG('y', "Checkpoint: Bad filename\n");
+				result = -1;
+				break;
 			}
+			if (currentThread->process->numThreads != 1)
+				DEBUG('y', "Checkpoint: Only single-threaded processes\n");
+			else
+				saved = currentThread->space->Checkpoint(name, registers);
+			DEBUG('y', "Checkpoint: \"%s\" %s\n", name, saved ? "saved" : "failed");
+			result = saved ? 0 : -1;
 			break;
 		}
 		case SC_Exec:
 		{
-			printf("Exec call\n");
-			int nameaddr = arg1;
-			int count = 0;
-			bool suc;
-			int value;
-			while (1)
+			DEBUG('y', "Exec call\n");
+			char name[MAX_PATH_LEN];
+			if (!ReadUserPath(arg1, name))
 			{
-				suc = machine->ReadMem(nameaddr + count, 1, &value);
-				if (!suc)
-					continue;
-				count++;
-				if (value == 0)
-					break;
-			}
-			printf("Exec: Filename length %d\n", count);
-			char name[count];
-			for (int i = 0; i < count; ++i)
-			{
-				machine->ReadMem(nameaddr + i, 1, &value);
-				name[i] = (char)value;
+				DEBUG('y', "Exec: Bad filename\n");
+				result = -1;
+				break;
 			}
 
-			printf("Exec: Filename \"%s\"\n", name);
-			bool alloc = false;
-			Thread *newThread = new Thread("child exec");
-			for (int i = 0; i < MAX_THREADS; ++i)
-			{
-				if (currentThread->childThread[i] == NULL)
-				{
-					currentThread->childThread[i] = newThread;
-					alloc = true;
-					break;
-				}
-			}
-			if (!alloc)
+			DEBUG('y', "Exec: Filename \"%s\"\n", name);
+			OpenFile *openFile = fileSystem->Open(name);
+			if (!openFile || pidMap->NumClear() == 0)
 			{
-				printf("Exec: Child thread of thread %d \"%s\" full\n", currentThread->getTid(), currentThread->getName());
+				DEBUG('y', "Exec: Cannot execute \"%s\"\n", name);
+				delete openFile;
+				result = -1;
 				break;
 			}
-			OpenFile *openFile = fileSystem->Open(name);
-			newThread->fatherThread = currentThread;
-			machine->WriteRegister(2, (int)newThread);
+			Process *child = new Process(name, currentThread->process);
+			Thread *newThread = new Thread("child exec");
+			newThread->process = child;
+			child->AddThread();
+			result = child->getPid();
 			newThread->Fork(exec_func, (void *)openFile);
-			printf("Exec complete\n");
+			DEBUG('y', "Exec complete\n");
 			break;
 		}
 		case SC_Fork:
 		{
-			printf("Fork call\n");
+			DEBUG('y', "Fork call\n");
 			int nextPC = arg1;
-			bool alloc = false;
-			AddrSpace *newSpace = new AddrSpace(currentThread->space);
-			Thread *newThread = new Thread("child fork");
-			for (int i = 0; i < MAX_THREADS; ++i)
+			int stackTop = currentThread->space->AllocStack();
+			if (stackTop == -1)
 			{
-				if (currentThread->childThread[i] == NULL)
-				{
-					currentThread->childThread[i] = newThread;
-					alloc = true;
-					break;
-				}
-			} //#define LRU
-			if (!alloc)
-			{
-				printf("Fork: Child thread of thread %d \"%s\" full\n", currentThread->getTid(), currentThread->getName());
+				DEBUG('y', "Fork: Too many threads!\n");
+				result = -1;
 				break;
 			}
-			newThread->fatherThread = currentThread;
-			newThread->space = newSpace;
+			Thread *newThread = new Thread("child fork");
+			newThread->process = currentThread->process;
+			newThread->process->AddThread();
+			newThread->space = currentThread->space;
+			newThread->space->Attach();
+			newThread->userStack = stackTop;
+			newThread->tickets = currentThread->tickets;
 			newThread->SaveUserState();
 			newThread->Fork(fork_func, (void *)nextPC);
-			printf("Fork complete\n");
+			result = 0;
+			DEBUG('y', "Fork complete\n");
 			break;
 		}
 		case SC_Yield:
 		{
-			printf("Yield call\n");
+			DEBUG('y', "Yield call\n");
 			break;
 		}
 		case SC_Join:
 		{
-			printf("Join call\n");
-			Thread *cThread = (Thread *)arg1;
-			int num;
-			bool found = false;
-			num = currentThread->FindChildID(cThread);
-			if (num != -1)
-			{
-				printf("Join: thread cannot found\n");
-			}
-			else
-			{
-				while (currentThread->childThread[num] != NULL)
-				{
-					currentThread->Yield();
-				}
-				printf("Join: child thread end\n");
-			}
+			DEBUG('y', "Join call\n");
+			int status = currentThread->process->Join(arg1);
+			DEBUG('y', "Join: child process %d end with status %d\n", arg1, status);
+			result = status;
 			break;
 		}
 		/* lab7 begin */
-		case SC_Ls:
+		case SC_ReadDir:
 		{
-			system("ls");
+			result = ReadDirEntries(arg1, arg2, arg3);
 			break;
 		}
-		case SC_Pwd:
+		case SC_GetCwd:
 		{
-			system("pwd");
+			char *cwd = currentThread->process->getCwd();
+			char root = '/';
+			int len = strlen(cwd) + 2; // leading '/' and '\0'
+			int retVal = -1;
+			if (arg2 >= len && CopyUser(arg1, &root, 1, FALSE) &&
+				CopyUser(arg1 + 1, cwd, len - 1, FALSE))
+				retVal = len - 1;
+			result = retVal;
 			break;
 		}
 		case SC_Chdir:
 		{
-			int nameaddr = arg1;
-			int count = 0;
-			bool suc;
-			int value;
-			while (1)
-			{
-				suc = machine->ReadMem(nameaddr + count, 1, &value);
-				if (!suc)
-					continue;
-				count++;
-				if (value == 0)
-					break;
-			}
-			char name[count];
-			for (int i = 0; i < count; ++i)
+			char path[MAX_PATH_LEN];
+			int retVal = -1;
+			if (ReadUserPath(arg1, path))
 			{
-				machine->ReadMem(nameaddr + i, 1, &value);
-				name[i] = (char)value;
+#ifdef FILESYS
+				OpenFile *dir = fileSystem->Open(path);
+				if (dir != NULL && dir->IsDirectory())
+					retVal = 0;
+				delete dir;
+#else
+				retVal = 0;
+#endif
 			}
-			int retVal = chdir(name);
-			machine->WriteRegister(2, retVal);
+			if (retVal == 0)
+				currentThread->process->setCwd(path);
+			result = retVal;
 			break;
 		}
 		case SC_Ps:
 		{
 			PrintThreadStates();
+			PrintProcessStates();
 			break;
 		}
 		/* lab7 end */
-		default:;
+		default:
+			result = -1;
 		}
+		machine->WriteRegister(2, result);
 		SyscallEnd(type);
+		syscallTracer->Record(type, args, result, startTick);
 	}
 	/* lab4 begin */
 	else if (which == PageFaultException)
-	{
-		int badVAddr = machine->registers[BadVAddrReg];
-		vpn = (unsigned)badVAddr / PageSize;
-		// use TLB
-		if (machine->tlb != NULL)
-		{
-			for (i = 0; i < TLBSize; ++i)
-			{
-				if (machine->tlb[i].valid == false)
-				{
-					machine->tlb[i].valid = true;
-					machine->tlb[i].interval = 0;
-					if (i == 0)
-						machine->tlb[0].replace = true;
-					machine->tlb[i].virtualPage = machine->tlb[i].physicalPage = vpn;
-					break;
-				}
-			}
-			if (i == TLBSize)
-			{
-#ifdef LRU
-				int LRUid, max_intv = -1;
-				for (i = 0; i < TLBSize; ++i)
-				{
-					if (machine->tlb[i].interval > max_intv)
-					{
-						LRUid = i;
-						max_intv = machine->tlb[i].interval;
-					}
-				}
-				machine->tlb[LRUid].interval = 0;
-				machine->tlb[LRUid].virtualPage = machine->tlb[LRUid].physicalPage = vpn;
-#else
-				int FIFOid;
-				for (i = 0; i < TLBSize; ++i)
-				{
-					if (machine->tlb[i].replace)
-					{
-						FIFOid = i;
-						machine->tlb[i].replace = false;
-						machine->tlb[(i + 1) % TLBSize].replace = true;
-						break;
-					}
-				}
-				machine->tlb[FIFOid].virtualPage = machine->tlb[FIFOid].physicalPage = vpn;
-#endif
-			}
-		}
-		// use pagetable
-		else
-		{
-			TranslationEntry *ptable = currentThread->space->pageTable;
-			int ppn;
-			int LRUid, max_intv = -1;
-			int npages = currentThread->space->numPages;
-
-			// Need replace(LRU)
-			if ((ppn = machine->memMap->Find()) == -1)
-			{
-				int poffset, voffset;
-				for (int i = 0; i < npages; ++i)
-				{
-					if (ptable[i].valid && (!ptable[i].noSwap) && (ptable[i].interval > max_intv))
-					{
-						max_intv = ptable[i].interval;
-						LRUid = i;
-					}
-				}
-				//printf("New vpn %d replace vpn %d in ppn %d\n", vpn, LRUid, ptable[LRUid].physicalPage);
-				if (ptable[LRUid].dirty)
-				{
-					poffset = ptable[LRUid].physicalPage * PageSize;
-					voffset = ptable[LRUid].virtualPage * PageSize;
-					currentThread->space->swapFile->WriteAt(&(machine->mainMemory[poffset]), PageSize, voffset);
-				}
-				ptable[LRUid].valid = FALSE;
-				ppn = ptable[LRUid].physicalPage;
-			}
-			//printf("Place vpn %d in ppn %d\n", vpn, ppn);
-			ptable[vpn].virtualPage = vpn;
-			ptable[vpn].physicalPage = ppn;
-			ptable[vpn].dirty = FALSE;
-			ptable[vpn].valid = TRUE;
-			ptable[vpn].use = TRUE;
-			ptable[vpn].interval = 0;
-			currentThread->space->swapFile->ReadAt(&(machine->mainMemory[ppn * PageSize]), PageSize, vpn * PageSize);
-		}
-	}
+		HandlePageFault(machine->registers[BadVAddrReg]);
 	/* lab4 end */
 	else
 	{
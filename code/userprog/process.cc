@@ -0,0 +1,346 @@
+// process.cc
+//	Routines to manage user processes: pid allocation, the per-process
+//	file descriptor table, and the exit/Join protocol between a
+//	process and its father.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "process.h"
+#include "system.h"
+#include "addrspace.h"
+#include "syscall.h"
+
+//----------------------------------------------------------------------
+// ProcessUsage::ProcessUsage
+// 	A new process has used nothing yet.
+//----------------------------------------------------------------------
+
+ProcessUsage::ProcessUsage()
+{
+    userTicks = systemTicks = 0;
+    pageFaults = tlbMisses = 0;
+    diskReads = diskWrites = 0;
+    numSyscalls = 0;
+    peakResidentPages = 0;
+}
+
+//----------------------------------------------------------------------
+// Process::Process
+// 	Allocate a pid, enter the new process in the process table, and
+//	link it into its father's list of children.  The caller must have
+//	checked that a pid is available.
+//
+//	"debugName" is copied, since it usually lives on the caller's stack.
+//	"father" is the process that may Join us, or NULL.
+//----------------------------------------------------------------------
+
+Process::Process(char *debugName, Process *fatherProcess)
+{
+    pid = pidMap->Find();
+    ASSERT(pid != -1);
+    processTable[pid] = this;
+
+    name = new char[strlen(debugName) + 1];
+    strcpy(name, debugName);
+    for (int i = 0; i < MAX_OPEN_FILES; i++)
+        fdTable[i] = NULL;
+
+    space = NULL;
+    exitStatus = 0;
+    numThreads = 0;
+    numOpenFiles = 0;
+
+    father = fatherProcess;
+    firstChild = NULL;
+    nextSibling = NULL;
+    if (father != NULL)
+    {
+        nextSibling = father->firstChild;
+        father->firstChild = this;
+        strcpy(cwd, father->cwd); // children start where we are
+        InheritPipes();
+    }
+    else
+        cwd[0] = '\0';
+    zombie = joined = FALSE;
+    exitSem = new Semaphore("process exit", 0);
+}
+
+//----------------------------------------------------------------------
+// Process::~Process
+// 	Release the pid.  By now the process has exited, so its address
+//	space and open files are already gone.
+//----------------------------------------------------------------------
+
+Process::~Process()
+{
+    processTable[pid] = NULL;
+    pidMap->Clear(pid);
+    delete exitSem;
+    delete[] name;
+}
+
+//----------------------------------------------------------------------
+// Process::AllocFd
+// 	Install "file" in the lowest free slot of the fd table.  Slots
+//	ConsoleInput and ConsoleOutput are reserved for the console.
+//	Return the new descriptor, or -1 if the table is full.
+//----------------------------------------------------------------------
+
+int Process::AllocFd(OpenFile *file)
+{
+    for (int fd = ConsoleOutput + 1; fd < MAX_OPEN_FILES; fd++)
+        if (fdTable[fd] == NULL)
+        {
+            fdTable[fd] = file;
+            numOpenFiles++;
+            return fd;
+        }
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Process::InheritPipes
+// 	Give a new child its own open file for each pipe end its father
+//	has open, at the same descriptor, so that a shell can connect
+//	the programs it runs.  Files are not inherited: each open file has
+//	a position of its own.
+//----------------------------------------------------------------------
+
+void Process::InheritPipes()
+{
+#ifdef FILESYS
+    for (int fd = ConsoleOutput + 1; fd < MAX_OPEN_FILES; fd++)
+    {
+        OpenFile *file = father->fdTable[fd];
+        if (file != NULL && file->usePipe)
+        {
+            fdTable[fd] = file->Dup();
+            numOpenFiles++;
+        }
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// Process::GetFile
+// 	Return the file open as "fd", or NULL if "fd" is out of range or
+//	not open.  A bounds check and an array index -- nothing else.
+//----------------------------------------------------------------------
+
+OpenFile *
+Process::GetFile(int fd)
+{
+    if (fd < 0 || fd >= MAX_OPEN_FILES)
+        return NULL;
+    return fdTable[fd];
+}
+
+//----------------------------------------------------------------------
+// Process::CloseFd
+// 	Close the file open as "fd" and free its slot.
+//----------------------------------------------------------------------
+
+bool Process::CloseFd(int fd)
+{
+    OpenFile *file = GetFile(fd);
+
+    if (file == NULL)
+        return FALSE;
+    aioManager->Drain(this, file); // the I/O worker may still be using it
+    delete file;
+    fdTable[fd] = NULL;
+    numOpenFiles--;
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Process::ResolvePath
+// 	Turn the user's file name "fileName" into a path from the root of
+//	the file system, in "path" (MAX_PATH_LEN bytes): a name starting with
+//	'/' is taken from the root, anything else from our current
+//	directory.  "." and ".." components are resolved here, so the file
+//	system only ever sees paths of the form "dir/dir/file" (or "" for
+//	the root itself).
+//
+//	Return FALSE if the result would be too long.
+//----------------------------------------------------------------------
+
+bool Process::ResolvePath(char *fileName, char *path)
+{
+    int len = 0;
+    char *component = fileName;
+
+    if (fileName[0] == '/')
+        path[0] = '\0';
+    else
+    {
+        strcpy(path, cwd);
+        len = strlen(path);
+    }
+
+    while (*component != '\0')
+    {
+        char *end = strchr(component, '/');
+        int compLen = (end == NULL) ? strlen(component) : end - component;
+
+        if (compLen == 0 || (compLen == 1 && component[0] == '.'))
+            ; // "//" or "."
+        else if (compLen == 2 && component[0] == '.' && component[1] == '.')
+        {
+            char *slash = strrchr(path, '/');
+            len = (slash == NULL) ? 0 : slash - path;
+            path[len] = '\0';
+        }
+        else
+        {
+            if (len + compLen + 2 > MAX_PATH_LEN)
+                return FALSE;
+            if (len > 0)
+                path[len++] = '/';
+            strncpy(path + len, component, compLen);
+            len += compLen;
+            path[len] = '\0';
+        }
+        component += compLen;
+        if (*component == '/')
+            component++;
+    }
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// Process::RemoveThread
+// 	One of our threads (the current thread) is finishing.  Give back
+//	its user stack and its hold on the address space; the last thread
+//	out of the address space frees it.  If it is the last thread of
+//	the process, the process exits.
+//
+//	The last thread out is detached before the space is deleted, since
+//	it still passes through Scheduler::Run on its way out.
+//----------------------------------------------------------------------
+
+void Process::RemoveThread()
+{
+    AddrSpace *threadSpace = currentThread->space;
+
+    ASSERT(numThreads > 0);
+    if (threadSpace != NULL)
+    {
+        if (currentThread->userStack != 0)
+            threadSpace->FreeStack(currentThread->userStack);
+        if (threadSpace->Detach())
+        {
+            currentThread->space = NULL;
+            if (space == threadSpace)
+                space = NULL;
+            delete threadSpace;
+        }
+    }
+    if (--numThreads == 0)
+        Exit();
+}
+
+//----------------------------------------------------------------------
+// Process::Exit
+// 	Tear down a process whose last thread is finishing: close its
+//	files, drop any asynchronous I/O it never collected, and orphan
+//	its children (reaping those that are already zombies).  The
+//	address space is already gone, with the last thread that ran in
+//	it.  If our father can still Join us, become a zombie and wake
+//	him up; otherwise nobody will ever ask for our exit status, so go
+//	away now.
+//----------------------------------------------------------------------
+
+void Process::Exit()
+{
+    for (int fd = 0; fd < MAX_OPEN_FILES; fd++)
+        (void)CloseFd(fd);
+    aioManager->Release(this);
+    if (DebugIsEnabled('y'))
+    {
+        profile.Print(pid, name);
+        PrintProcessStates();
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    while (firstChild != NULL)
+    {
+        Process *child = firstChild;
+        firstChild = child->nextSibling;
+        child->father = NULL;
+        if (child->zombie)
+            delete child;
+    }
+
+    if (father != NULL)
+    {
+        zombie = TRUE;
+        exitSem->V();
+    }
+    else
+        delete this;
+    (void)interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Process::Join
+// 	Wait for our child "childPid" to exit, then reap it and return its
+//	exit status.  The pid is checked against the process table in
+//	constant time; anything that is not one of our children gets -1.
+//	The child is taken off our list before we wait, and marked, so
+//	that another of our threads joining it also gets -1.
+//----------------------------------------------------------------------
+
+int Process::Join(int childPid)
+{
+    if (childPid < 0 || childPid >= MAX_PROCESSES)
+        return -1;
+
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Process *child = processTable[childPid];
+    if (child == NULL || child->father != this || child->joined)
+    {
+        (void)interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+    child->joined = TRUE;
+    Process **link = &firstChild;
+    while (*link != child)
+        link = &(*link)->nextSibling;
+    *link = child->nextSibling;
+
+    child->exitSem->P(); // returns at once if it is already a zombie
+    int status = child->exitStatus;
+    delete child;
+    (void)interrupt->SetLevel(oldLevel);
+    return status;
+}
+
+//----------------------------------------------------------------------
+// PrintProcessStates
+// 	Print what every process in the process table has used so far,
+//	for Ps and Halt.  Zombies are included, since they keep their
+//	counters until they are reaped.
+//----------------------------------------------------------------------
+
+void PrintProcessStates()
+{
+    putchar('\n');
+    printf("PID  NAME          THR    USER     SYS  FAULT   TLBMISS  DREAD DWRITE  SYSCALL PEAKPG\n");
+    for (int i = 0; i < MAX_PROCESSES; i++)
+    {
+        Process *p = processTable[i];
+        if (p == NULL)
+            continue;
+        ProcessUsage *u = &p->usage;
+        printf("%-5d%-14.13s%3d%8d%8d%7d%10d%7d%7d%9d%7d%s\n", i, p->getName(),
+               p->numThreads, u->userTicks, u->systemTicks, u->pageFaults,
+               u->tlbMisses, u->diskReads, u->diskWrites, u->numSyscalls,
+               u->peakResidentPages, (p->numThreads == 0) ? " (zombie)" : "");
+    }
+    putchar('\n');
+}
@@ -0,0 +1,125 @@
+// process.h
+//	Data structures to keep track of user processes.
+//
+//	A process is the unit that owns resources on behalf of a user
+//	program: an address space, a table of open files, and the
+//	bookkeeping needed so that its father can Join it.  The threads
+//	running the program only point back to their process; a process
+//	lives until the last of its threads has finished, and then (if its
+//	father is still around) lingers as a zombie until it is reaped.
+//
+//	User programs never see kernel pointers.  Exec returns a small
+//	process id (an index into "processTable"), and Open returns a small
+//	file descriptor (an index into the process' "fdTable"), so both
+//	can be validated and looked up in constant time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "openfile.h"
+#include "strace.h"
+
+#define MAX_PROCESSES 64  // size of the process table
+#define MAX_OPEN_FILES 16 // size of each per-process fd table,
+                          // including ConsoleInput and ConsoleOutput
+#define MAX_PATH_LEN 128  // longest path name, including the '\0'
+
+class AddrSpace;
+class Semaphore;
+
+// Resources a process has used, charged to it at the point where they
+// are consumed: ticks in Interrupt::OneTick, faults and system calls in
+// ExceptionHandler, disk I/O in SynchDisk.
+class ProcessUsage
+{
+  public:
+    ProcessUsage();
+
+    void NoteResident(int numPages) // keep the high-water mark
+    {
+        if (numPages > peakResidentPages)
+            peakResidentPages = numPages;
+    }
+
+    int userTicks;         // user instructions executed
+    int systemTicks;       // kernel time spent on our behalf
+    int pageFaults;        // pages brought in from the swap file
+    int tlbMisses;         // TLB refills
+    int diskReads;         // sectors read
+    int diskWrites;        // sectors written
+    int numSyscalls;       // system calls made
+    int peakResidentPages; // most physical pages held at once
+};
+
+class Process
+{
+  public:
+    Process(char *debugName, Process *father); // allocate a pid, and link
+                                               // us into "father"'s children
+    ~Process();                                // release the pid
+
+    int getPid() { return (pid); }
+    char *getName() { return (name); }
+
+    // file descriptors
+    int AllocFd(OpenFile *file); // Install "file" in the lowest free slot;
+                                 // return the fd, or -1 if the table is full
+    OpenFile *GetFile(int fd);   // Return the file behind "fd", or NULL
+                                 // if "fd" is not an open file
+    bool CloseFd(int fd);        // Close "fd"; FALSE if it was not open
+
+    // current directory
+    bool ResolvePath(char *fileName, char *path); // Turn "fileName"
+                                                  // into a path from
+                                                  // the root, relative
+                                                  // to our current
+                                                  // directory
+    char *getCwd() { return (cwd); }          // "" is the root
+    void setCwd(char *path) { strcpy(cwd, path); } // "path" is resolved
+
+    // threads
+    void AddThread() { numThreads++; } // another thread runs in us
+    void RemoveThread();               // called by Thread::Finish; the
+                                       // last thread out tears us down
+
+    // parent and children
+    int Join(int childPid); // wait for child "childPid" to exit, reap it,
+                            // and return its exit status (-1 if it is
+                            // not one of our children)
+
+    AddrSpace *space;  // the program this process is running
+    int exitStatus;    // passed to Exit, collected by Join
+
+    // resource counters
+    int numThreads;   // threads still running in this process
+    int numOpenFiles; // descriptors currently in use
+    ProcessUsage usage;     // machine resources consumed so far
+    SyscallProfile profile; // system calls made, and how long they took
+
+  private:
+    void Exit(); // release our resources, orphan our children, and
+                 // either become a zombie or delete ourselves
+    void InheritPipes(); // open each of our father's pipe ends too
+
+    int pid;
+    char *name;
+    OpenFile *fdTable[MAX_OPEN_FILES];
+    char cwd[MAX_PATH_LEN]; // current directory, as a path from the root
+
+    Process *father;      // NULL once the father has exited
+    Process *firstChild;  // head of the list of our children
+    Process *nextSibling; // next child of our father
+    bool zombie;          // TRUE once we have exited
+    bool joined;          // a thread of our father is in Join for us
+    Semaphore *exitSem;   // V'ed when we exit, P'ed by Join
+};
+
+extern void PrintProcessStates(); // resource usage of every process
+
+#endif // PROCESS_H
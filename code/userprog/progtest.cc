@@ -30,10 +30,11 @@ void StartProcess(char *filename)
         printf("Unable to open file %s\n", filename);
         return;
     }
+    currentThread->process = new Process(filename, NULL);
+    currentThread->process->AddThread();
     space = new AddrSpace(executable);
-    currentThread->space = space;
-
-    delete executable; // close file
+    currentThread->space = currentThread->process->space = space;
+    space->Attach(); // the space keeps "executable" open
 
     space->InitRegisters(); // set the initial register values
     space->RestoreState();  // load page table register
@@ -55,10 +56,11 @@ StartSort(int dummy)
         printf("Unable to open file %s\n", filename);
         return;
     }
+    currentThread->process = new Process(filename, NULL);
+    currentThread->process->AddThread();
     space = new AddrSpace(executable);
-    currentThread->space = space;
-
-    delete executable; 
+    currentThread->space = currentThread->process->space = space;
+    space->Attach();
 
     space->InitRegisters(); 
     space->RestoreState();  
@@ -78,10 +80,11 @@ StartMatmult(int dummy)
         printf("Unable to open file %s\n", filename);
         return;
     }
+    currentThread->process = new Process(filename, NULL);
+    currentThread->process->AddThread();
     space = new AddrSpace(executable);
-    currentThread->space = space;
-
-    delete executable; 
+    currentThread->space = currentThread->process->space = space;
+    space->Attach();
 
     space->InitRegisters(); 
     space->RestoreState();  
@@ -0,0 +1,168 @@
+// strace.cc
+//	Routines to profile system calls per process, and to trace every
+//	call to the console or to a binary trace file.  See strace.h.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "strace.h"
+#include "system.h"
+
+const char *syscallNames[NumSyscallTypes] = SyscallNames;
+
+//----------------------------------------------------------------------
+// LatencyBucket
+// 	Return the histogram bucket for a call that took "ticks".
+//----------------------------------------------------------------------
+
+static int LatencyBucket(int ticks)
+{
+    int bucket = 0;
+
+    while (ticks > 0 && bucket < NumLatencyBuckets - 1)
+    {
+        ticks >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+//----------------------------------------------------------------------
+// SyscallProfile::SyscallProfile
+// 	Start with every counter at zero.
+//----------------------------------------------------------------------
+
+SyscallProfile::SyscallProfile()
+{
+    memset(calls, 0, sizeof(calls));
+    memset(totalTicks, 0, sizeof(totalTicks));
+    memset(maxTicks, 0, sizeof(maxTicks));
+    memset(histogram, 0, sizeof(histogram));
+}
+
+//----------------------------------------------------------------------
+// SyscallProfile::Record
+// 	Count one call of "type" that took "ticks".
+//----------------------------------------------------------------------
+
+void SyscallProfile::Record(int type, int ticks)
+{
+    if (type < 0 || type >= NumSyscallTypes)
+        return;
+    calls[type]++;
+    totalTicks[type] += ticks;
+    if (ticks > maxTicks[type])
+        maxTicks[type] = ticks;
+    histogram[type][LatencyBucket(ticks)]++;
+}
+
+//----------------------------------------------------------------------
+// SyscallProfile::Print
+// 	Print a row for every kind of call the process made: the count,
+//	the mean and worst latency, and the non-empty histogram buckets,
+//	each shown by its upper bound in ticks.
+//----------------------------------------------------------------------
+
+void SyscallProfile::Print(int pid, char *name)
+{
+    printf("System calls of process %d (%s):\n", pid, name);
+    printf("  %-10s %8s %8s %8s   latency histogram\n",
+           "call", "count", "avg", "max");
+    for (int type = 0; type < NumSyscallTypes; type++)
+    {
+        if (calls[type] == 0)
+            continue;
+        printf("  %-10s %8d %8d %8d  ",
+               (syscallNames[type] != NULL) ? syscallNames[type] : "?",
+               calls[type], totalTicks[type] / calls[type], maxTicks[type]);
+        for (int bucket = 0; bucket < NumLatencyBuckets; bucket++)
+            if (histogram[type][bucket] != 0)
+            {
+                if (bucket == NumLatencyBuckets - 1)
+                    printf(" >=%d:%d", 1 << (bucket - 1), histogram[type][bucket]);
+                else
+                    printf(" <%d:%d", 1 << bucket, histogram[type][bucket]);
+            }
+        printf("\n");
+    }
+}
+
+//----------------------------------------------------------------------
+// SyscallTracer::SyscallTracer
+// 	Open the trace file, if any, and write its header.
+//----------------------------------------------------------------------
+
+SyscallTracer::SyscallTracer(char *fileName)
+{
+    traceFile = -1;
+    numBuffered = 0;
+    if (fileName != NULL)
+    {
+        TraceHeader header;
+
+        traceFile = OpenForWrite(fileName);
+        ASSERT(traceFile != -1);
+        header.magic = TraceMagic;
+        header.version = TraceVersion;
+        WriteFile(traceFile, (char *)&header, sizeof(header));
+    }
+}
+
+SyscallTracer::~SyscallTracer()
+{
+    if (traceFile != -1)
+    {
+        Flush();
+        Close(traceFile);
+    }
+}
+
+//----------------------------------------------------------------------
+// SyscallTracer::Record
+// 	Charge a finished system call to the current process, print it
+//	if the 'y' debug flag is on, and buffer a record of it for the
+//	trace file.
+//----------------------------------------------------------------------
+
+void SyscallTracer::Record(int type, int *args, int result, int startTick)
+{
+    int endTick = stats->totalTicks;
+    Process *process = currentThread->process;
+    int pid = (process != NULL) ? process->getPid() : -1;
+
+    if (process != NULL)
+        process->profile.Record(type, endTick - startTick);
+
+    DEBUG('y', "[%d] %s(%d, %d, %d, %d) = %d <%d ticks>\n", pid,
+          (type >= 0 && type < NumSyscallTypes && syscallNames[type] != NULL)
+              ? syscallNames[type] : "?",
+          args[0], args[1], args[2], args[3], result, endTick - startTick);
+
+    if (traceFile == -1)
+        return;
+
+    TraceRecord *record = &buffer[numBuffered++];
+    record->pid = pid;
+    record->type = type;
+    for (int i = 0; i < 4; i++)
+        record->args[i] = args[i];
+    record->result = result;
+    record->startTick = startTick;
+    record->endTick = endTick;
+    if (numBuffered == TraceBufferSize)
+        Flush();
+}
+
+//----------------------------------------------------------------------
+// SyscallTracer::Flush
+// 	Write the buffered records out in one host write.
+//----------------------------------------------------------------------
+
+void SyscallTracer::Flush()
+{
+    if (numBuffered > 0)
+        WriteFile(traceFile, (char *)buffer, numBuffered * sizeof(TraceRecord));
+    numBuffered = 0;
+}
@@ -0,0 +1,71 @@
+// strace.h
+//	Data structures for tracing and profiling system calls.
+//
+//	Every system call is timed in simulated ticks, from the moment the
+//	kernel is entered until it returns to user mode (so a call that
+//	blocks, like Join or Read from the disk, is charged for the time it
+//	was blocked).  The result is recorded in two places:
+//
+//	  the calling process' SyscallProfile -- a count, total, maximum
+//	  and latency histogram for each kind of system call, printed
+//	  when the process exits if the 'y' debug flag is on;
+//
+//	  the global SyscallTracer -- which prints one line per call
+//	  (again with -d y), and, if Nachos was started with -st <file>,
+//	  appends a binary TraceRecord to <file> for bin/tracedump.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef STRACE_H
+#define STRACE_H
+
+#include "copyright.h"
+#include "utility.h"
+#include "tracefmt.h"
+
+#define NumLatencyBuckets 16 // bucket 0 holds 0 ticks, bucket i holds
+                             // [2^(i-1), 2^i) ticks, and the last bucket
+                             // holds everything longer
+#define TraceBufferSize 64   // records buffered before a host write
+
+// Per-process system call counters.
+class SyscallProfile
+{
+  public:
+    SyscallProfile(); // all counters zero
+
+    void Record(int type, int ticks);   // account for one call
+    void Print(int pid, char *name);    // print the non-empty rows
+
+  private:
+    int calls[NumSyscallTypes];
+    int totalTicks[NumSyscallTypes];
+    int maxTicks[NumSyscallTypes];
+    int histogram[NumSyscallTypes][NumLatencyBuckets];
+};
+
+// The system-wide tracer.
+class SyscallTracer
+{
+  public:
+    SyscallTracer(char *fileName); // stream records to the host file
+                                   // "fileName", unless it is NULL
+    ~SyscallTracer();              // flush any buffered records
+
+    void Record(int type, int *args, int result, int startTick);
+    // The current thread's system call "type", entered at "startTick"
+    // with "args", is returning "result".
+
+  private:
+    void Flush(); // write the buffered records to the trace file
+
+    int traceFile; // host file descriptor, or -1
+    TraceRecord buffer[TraceBufferSize];
+    int numBuffered;
+};
+
+extern const char *syscallNames[];
+
+#endif // STRACE_H
@@ -29,10 +29,22 @@
 #define SC_Close	8
 #define SC_Fork		9
 #define SC_Yield	10
-#define SC_Ls		11
-#define SC_Pwd		12
+#define SC_ReadDir	11
+#define SC_GetCwd	12
 #define SC_Chdir	13
 #define SC_Ps		14
+#define SC_ReadV	15
+#define SC_WriteV	16
+#define SC_CopyFile	17
+#define SC_AioRead	18
+#define SC_AioWrite	19
+#define SC_AioPoll	20
+#define SC_AioWait	21
+#define SC_Sbrk		22
+#define SC_Checkpoint	23
+#define SC_SetShare	24
+#define SC_Sleep	25
+#define SC_MakePipe	26
 
 #ifndef IN_ASM
 
@@ -55,16 +67,16 @@ void Halt();
 /* This user program is done (status = 0 means exited normally). */
 void Exit(int status);	
 
-/* A unique identifier for an executing user program (address space) */
+/* A unique identifier for an executing user program (a small process id) */
 typedef int SpaceId;	
  
 /* Run the executable, stored in the Nachos file "name", and return the 
- * address space identifier
+ * address space identifier, or -1 if it cannot be run
  */
 SpaceId Exec(char *name);
  
 /* Only return once the the user program "id" has finished.  
- * Return the exit status.
+ * Return the exit status, or -1 if "id" is not a child of the caller.
  */
 int Join(SpaceId id); 	
  
@@ -78,13 +90,14 @@ int Join(SpaceId id);
  * will work for the purposes of testing out these routines.
  */
  
-/* A unique identifier for an open Nachos file. */
+/* A unique identifier for an open Nachos file (a small per-process index). */
 typedef int OpenFileId;	
 
 /* when an address space starts up, it has two open files, representing 
  * keyboard input and display output (in UNIX terms, stdin and stdout).
  * Read and Write can be used directly on these, without first opening
- * the console device.
+ * the console device.  Console input is line-buffered: Read waits for
+ * a whole line to be typed, and returns no more than that one line.
  */
 
 #define ConsoleInput	0  
@@ -94,11 +107,13 @@ typedef int OpenFileId;
 void Create(char *name);
 
 /* Open the Nachos file "name", and return an "OpenFileId" that can 
- * be used to read and write to the file.
+ * be used to read and write to the file, or -1 on failure.
  */
 OpenFileId Open(char *name);
 
-/* Write "size" bytes from "buffer" to the open file. */
+/* Write "size" bytes from "buffer" to the open file.  Buffers of any
+ * size are fine; the kernel moves them a few sectors at a time.
+ */
 void Write(char *buffer, int size, OpenFileId id);
 
 /* Read "size" bytes from the open file into "buffer".  
@@ -112,6 +127,98 @@ int Read(char *buffer, int size, OpenFileId id);
 /* Close the file, we're done reading and writing to it. */
 void Close(OpenFileId id);
 
+/* Create a pipe, and open its two ends: "fds[0]" to read from and
+ * "fds[1]" to write to.  Bytes come out in the order they went in.  A
+ * Read waits until there is something in the pipe, then returns what
+ * is there; it returns 0 once every write end is closed and the pipe
+ * is empty.  A Write waits for room, and stops short if every read end
+ * is closed.  Exec'ed children inherit open pipe ends, at the same
+ * descriptors.  Return 0, or -1 if the process has too many open files.
+ */
+int MakePipe(OpenFileId *fds);
+
+/* One segment of a vectored read or write. */
+typedef struct {
+    char *buffer;
+    int size;
+} IoVec;
+
+/* Read from the open file into the "iovcnt" (at most 16) buffers
+ * described by "iov", filling each in turn before moving on to the
+ * next.  Return the total number of bytes read, or -1 on error.
+ */
+int ReadV(IoVec *iov, int iovcnt, OpenFileId id);
+
+/* Write the "iovcnt" buffers described by "iov" to the open file, in
+ * order.  Return the total number of bytes written, or -1 on error.
+ */
+int WriteV(IoVec *iov, int iovcnt, OpenFileId id);
+
+/* Copy up to "len" bytes of the open file "src", starting at "offset",
+ * to the open file "dst" at its current position, entirely inside the
+ * kernel.  The position of "src" does not change.  Return the number
+ * of bytes copied (fewer than "len" if "src" ends first), or -1.
+ */
+int CopyFile(OpenFileId src, OpenFileId dst, int offset, int len);
+
+/* Asynchronous I/O.  AioRead and AioWrite start a transfer of "size"
+ * bytes (at most 16K) at the current position of the open file, move
+ * the position past it, and return at once with a request id (or -1).
+ * The contents of "buffer" after an AioRead are only defined once the
+ * request has been collected with AioPoll; the buffer of an AioWrite
+ * may be reused as soon as AioWrite returns.
+ */
+typedef int AioId;
+
+#define AioPending	-2
+
+AioId AioRead(char *buffer, int size, OpenFileId id);
+AioId AioWrite(char *buffer, int size, OpenFileId id);
+
+/* If request "id" has finished, return the number of bytes transferred
+ * and forget the request; otherwise return AioPending.
+ */
+int AioPoll(AioId id);
+
+/* Block until at least one of the "count" requests in "ids" has
+ * finished, and return its index in "ids" (or -1 on error).  Collect
+ * it with AioPoll.
+ */
+int AioWait(AioId *ids, int count);
+
+
+
+/* Move the end of the heap (the "break") by "increment" bytes, and
+ * return the old break -- so Sbrk(n) returns the start of n new bytes,
+ * and Sbrk(0) returns the current break.  New memory reads as zero,
+ * and only takes up physical memory once it is touched.  Return -1 if
+ * the heap cannot grow (or shrink) that far.  See malloc.h for an
+ * allocator built on top of it.
+ */
+void *Sbrk(int increment);
+
+/* Save the state of this process -- its memory and registers -- to
+ * the file "name", so that it can be picked up later.  Exec'ing the
+ * file (or running it with "nachos -x") starts a new process that
+ * carries on from this call, which returns 1 there; here it returns
+ * 0, or -1 if the checkpoint could not be written.  Only a process
+ * with a single thread can be checkpointed, and its open files are
+ * not saved.
+ */
+int Checkpoint(char *name);
+
+/* Set how many tickets the calling thread holds, from 1 to 10000
+ * (100 to begin with).  When Nachos runs with "-sched stride", each
+ * thread gets the CPU in proportion to its tickets; threads it Forks
+ * start with the same number.  Return the old number of tickets, or
+ * -1 if "tickets" is out of range.
+ */
+int SetShare(int tickets);
+
+/* Block the calling thread until at least "ticks" of simulated time
+ * have passed, leaving the CPU to other threads.  Returns 0.
+ */
+int Sleep(int ticks);
 
 
 /* User-level thread operations: Fork and Yield.  To allow multiple
@@ -119,23 +226,68 @@ void Close(OpenFileId id);
  */
 
 /* Fork a thread to run a procedure ("func") in the *same* address space 
- * as the current thread.
+ * as the current thread.  The new thread shares the program's code,
+ * globals and heap, but has a stack of its own (UserStackSize bytes),
+ * so "func" must not return: it should end by calling Exit.  Return 0,
+ * or -1 if the address space already has MaxUserThreads Fork'ed
+ * threads.
  */
-void Fork(void (*func)());
+int Fork(void (*func)());
 
 /* Yield the CPU to another runnable thread, whether in this address space 
  * or not. 
  */
 void Yield();
 
-void Ls();	
+/* Directories.  A file name that does not start with '/' is taken
+ * relative to the current directory of the calling process, which
+ * Exec'ed children inherit.  Open a directory (e.g. ".") to list it.
+ */
+
+/* One entry returned by ReadDir. */
+typedef struct {
+    char name[128];
+    int isDir;		/* 1 for a directory, 0 for a file */
+} DirEnt;
 
-void Pwd();	
+/* Copy up to "n" entries of the open directory "id" into "entries",
+ * continuing after the ones returned by the last call.  Return the
+ * number copied (0 once the directory is exhausted), or -1 if "id" is
+ * not an open directory.
+ */
+int ReadDir(OpenFileId id, DirEnt *entries, int n);
 
+/* Copy the current directory, as an absolute path, into "buffer".
+ * Return its length, or -1 if "size" bytes are not enough.
+ */
+int GetCwd(char *buffer, int size);
+
+/* Change the current directory.  Return 0, or -1 if "name" is not a
+ * directory.
+ */
 int Chdir(char *name);
 
 void Ps();
 
+/* The kernel info page.  Every address space can read (but not write)
+ * a KernelInfo at KernelInfoAddr, which the kernel keeps up to date, so
+ * that none of these needs a system call -- for instance, to time a
+ * loop without disturbing it:
+ *
+ *	int start = KernelInfoPtr->ticks;
+ *	...
+ *	elapsed = KernelInfoPtr->ticks - start;
+ */
+typedef struct {
+    int ticks;		/* simulated time since Nachos started */
+    int pid;		/* the running process */
+    int tid;		/* the running thread */
+    int cpu;		/* the CPU it is running on */
+} KernelInfo;		/* in the order of InfoTicks.. in machine.h */
+
+#define KernelInfoAddr	0x7fff0000	/* same as in machine.h */
+#define KernelInfoPtr	((volatile KernelInfo *) KernelInfoAddr)
+
 #endif /* IN_ASM */
 
 #endif /* SYSCALL_H */
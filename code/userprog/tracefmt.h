@@ -0,0 +1,46 @@
+/* tracefmt.h
+ *	Format of the binary system call trace written by "nachos -st
+ *	<file>" and read back by bin/tracedump.
+ *
+ *	The file is a TraceHeader followed by any number of TraceRecords,
+ *	one per system call, in the byte order of the host that ran Nachos.
+ *	This header is shared by the kernel and the (C) decoder, so it
+ *	must stay plain C.
+ *
+ * Copyright (c) 1992-1993 The Regents of the University of California.
+ * All rights reserved.  See copyright.h for copyright notice and limitation
+ * of liability and disclaimer of warranty provisions.
+ */
+
+#ifndef TRACEFMT_H
+#define TRACEFMT_H
+
+#define TraceMagic	0x4e545243	/* "NTRC" */
+#define TraceVersion	1
+
+typedef struct {
+    int magic;			/* TraceMagic */
+    int version;		/* TraceVersion */
+} TraceHeader;
+
+typedef struct {
+    int pid;			/* process that made the call */
+    int type;			/* SC_xxx, from syscall.h */
+    int args[4];		/* r4 - r7 at entry */
+    int result;			/* r2 at exit */
+    int startTick;		/* stats->totalTicks at entry */
+    int endTick;		/* ... and at exit */
+} TraceRecord;
+
+/* Names of the system calls, indexed by SC_xxx.  Keep in step with
+ * syscall.h.
+ */
+#define NumSyscallTypes	32
+
+#define SyscallNames {							\
+    "Halt", "Exit", "Exec", "Join", "Create", "Open", "Read", "Write",	\
+    "Close", "Fork", "Yield", "ReadDir", "GetCwd", "Chdir", "Ps",	\
+    "ReadV", "WriteV", "CopyFile", "AioRead", "AioWrite", "AioPoll",	\
+    "AioWait", "Sbrk", "Checkpoint", "SetShare", "Sleep", "MakePipe" }
+
+#endif /* TRACEFMT_H */